@@ -0,0 +1,464 @@
+#include <QApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPixmap>
+#include <QSemaphore>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <QXmlStreamReader>
+#include <QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "KeyButton.h"
+#include "KeyEventQueue.h"
+#include "VirtualKeyboardWidget.h"
+
+// 控件热点路径基准：按键记录、多线程事件队列、热力图重算、键帽绘制、构造、缩放与高亮动画。
+// 运行 VirtualKeyboardBenchmarks --json results.json 额外输出机器可读结果
+class VirtualKeyboardBenchmarks : public QObject {
+    Q_OBJECT
+private slots:
+    void recordKey_data();
+    void recordKey();
+    void sharedModelRecordKey_data();
+    void sharedModelRecordKey();
+    void keyStorm_data();
+    void keyStorm();
+    void queueStress_data();
+    void queueStress();
+    void refreshHeatMap_data();
+    void refreshHeatMap();
+    void keyButtonPaint_data();
+    void keyButtonPaint();
+    void construction();
+    void resizeAutoScale_data();
+    void resizeAutoScale();
+    void glowCpuMsPerSecond_data();
+    void glowCpuMsPerSecond();
+
+private:
+    // 一组覆盖主键区的按键，循环使用
+    static QList<int> sampleKeys();
+};
+
+namespace {
+void addRenderModeRows() {
+    QTest::addColumn<VirtualKeyboardWidget::RenderMode>("renderMode");
+    QTest::newRow("widgets") << VirtualKeyboardWidget::RenderMode::Widgets;
+    QTest::newRow("batched") << VirtualKeyboardWidget::RenderMode::Batched;
+}
+
+// 进程累计 CPU 时间（用户态 + 内核态，毫秒）
+qreal processCpuMs() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    const auto toMs = [](const FILETIME &time) {
+        return ((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000.0;
+    };
+    return toMs(kernel) + toMs(user);
+#else
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto toMs = [](const timeval &time) {
+        return time.tv_sec * 1000.0 + time.tv_usec / 1000.0;
+    };
+    return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+#endif
+}
+
+// 按给定渲染模式创建并显示键盘，不监听全局键盘避免干扰
+void prepareKeyboard(VirtualKeyboardWidget &keyboard, VirtualKeyboardWidget::RenderMode mode) {
+    keyboard.setTrackPhysicalKeyboard(false);
+    keyboard.setRenderMode(mode);
+    keyboard.resize(960, 320);
+    keyboard.show();
+}
+} // namespace
+
+QList<int> VirtualKeyboardBenchmarks::sampleKeys() {
+    return {Qt::Key_A, Qt::Key_S, Qt::Key_D, Qt::Key_F, Qt::Key_J, Qt::Key_K, Qt::Key_L,
+            Qt::Key_E, Qt::Key_R, Qt::Key_T, Qt::Key_N, Qt::Key_O, Qt::Key_Space, Qt::Key_Return};
+}
+
+void VirtualKeyboardBenchmarks::recordKey_data() {
+    QTest::addColumn<VirtualKeyboardWidget::RenderMode>("renderMode");
+    QTest::addColumn<bool>("frameCoalescing");
+    QTest::newRow("widgets") << VirtualKeyboardWidget::RenderMode::Widgets << false;
+    QTest::newRow("widgets-coalesced") << VirtualKeyboardWidget::RenderMode::Widgets << true;
+    QTest::newRow("batched") << VirtualKeyboardWidget::RenderMode::Batched << false;
+    QTest::newRow("batched-coalesced") << VirtualKeyboardWidget::RenderMode::Batched << true;
+}
+
+void VirtualKeyboardBenchmarks::recordKey() {
+    QFETCH(VirtualKeyboardWidget::RenderMode, renderMode);
+    QFETCH(bool, frameCoalescing);
+
+    VirtualKeyboardWidget keyboard;
+    prepareKeyboard(keyboard, renderMode);
+    QVERIFY(QTest::qWaitForWindowExposed(&keyboard));
+    keyboard.setFrameCoalescing(frameCoalescing);
+
+    const QList<int> keys = sampleKeys();
+    int next = 0;
+    QBENCHMARK {
+        keyboard.recordKey(keys.at(next));
+        next = (next + 1) % keys.size();
+    }
+    keyboard.flushPendingUpdates();
+}
+
+void VirtualKeyboardBenchmarks::sharedModelRecordKey_data() {
+    QTest::addColumn<int>("viewCount");
+    QTest::newRow("1-view") << 1;
+    QTest::newRow("4-views") << 4;
+}
+
+void VirtualKeyboardBenchmarks::sharedModelRecordKey() {
+    QFETCH(int, viewCount);
+
+    // 多个批量渲染视图订阅同一个模型，每次按键只计数一次，各视图只处理变化的键
+    KeyStatisticsModel model;
+    std::vector<std::unique_ptr<VirtualKeyboardWidget>> views;
+    for (int i = 0; i < viewCount; ++i) {
+        views.push_back(std::make_unique<VirtualKeyboardWidget>());
+        prepareKeyboard(*views.back(), VirtualKeyboardWidget::RenderMode::Batched);
+        views.back()->setStatisticsModel(&model);
+    }
+    QVERIFY(QTest::qWaitForWindowExposed(views.front().get()));
+
+    const QList<int> keys = sampleKeys();
+    int next = 0;
+    QBENCHMARK {
+        model.recordKey(keys.at(next));
+        next = (next + 1) % keys.size();
+    }
+    model.flush();
+}
+
+void VirtualKeyboardBenchmarks::keyStorm_data() {
+    QTest::addColumn<int>("keyRateLimit");
+    QTest::newRow("unlimited") << 0;
+    QTest::newRow("limit-30") << 30;
+}
+
+void VirtualKeyboardBenchmarks::keyStorm() {
+    QFETCH(int, keyRateLimit);
+
+    // 模拟卡键：同一个键连续灌入，限流后超出部分只计数，每帧合并为一批
+    VirtualKeyboardWidget keyboard;
+    prepareKeyboard(keyboard, VirtualKeyboardWidget::RenderMode::Batched);
+    QVERIFY(QTest::qWaitForWindowExposed(&keyboard));
+    keyboard.setKeyRateLimit(keyRateLimit);
+
+    QBENCHMARK {
+        keyboard.recordKey(Qt::Key_A);
+    }
+    keyboard.flushPendingUpdates();
+}
+
+void VirtualKeyboardBenchmarks::queueStress_data() {
+    QTest::addColumn<int>("producers");
+    QTest::newRow("2-producers") << 2;
+    QTest::newRow("4-producers") << 4;
+    QTest::newRow("8-producers") << 8;
+}
+
+void VirtualKeyboardBenchmarks::queueStress() {
+    QFETCH(int, producers);
+
+    // 多个生产者线程并发写入，消费者只在被唤醒时 drain，按模型的方式处理完一批后 rearmNotifier。
+    // 唤醒丢失时消费者会在仍有积压的情况下一直等下去，这里以超时判定失败；同时校验每个生产者的事件
+    // 全部送达且顺序不变
+    constexpr int EventsPerProducer = 20000;
+    KeyEventQueue queue(1024);
+    QSemaphore wakeups;
+    queue.setNotifier([&wakeups]() { wakeups.release(); });
+
+    QBENCHMARK {
+        std::atomic<bool> stop {false};
+        std::vector<std::thread> threads;
+        for (int producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&queue, &stop, producer]() {
+                for (int i = 0; i < EventsPerProducer && !stop.load(std::memory_order_relaxed); ++i) {
+                    // 队列满时让出时间片后重试，保证事件总数确定
+                    while (!queue.push(producer * EventsPerProducer + i)) {
+                        if (stop.load(std::memory_order_relaxed)) {
+                            return;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        QVector<int> nextExpected(producers, 0);
+        bool ordered = true;
+        bool lostWakeup = false;
+        int received = 0;
+        int buffer[256];
+        while (received < producers * EventsPerProducer) {
+            if (!wakeups.tryAcquire(1, 2000)) {
+                lostWakeup = true;
+                break;
+            }
+            do {
+                int count = 0;
+                while ((count = queue.drain(buffer, 256)) > 0) {
+                    for (int i = 0; i < count; ++i) {
+                        const int producer = buffer[i] / EventsPerProducer;
+                        ordered = ordered && buffer[i] % EventsPerProducer == nextExpected[producer];
+                        ++nextExpected[producer];
+                    }
+                    received += count;
+                }
+            } while (queue.rearmNotifier());
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        QVERIFY2(!lostWakeup, "consumer was not woken while events were queued");
+        QVERIFY(ordered);
+        QCOMPARE(received, producers * EventsPerProducer);
+        // 本轮多余的唤醒令牌不带到下一轮
+        wakeups.tryAcquire(wakeups.available());
+    }
+}
+
+void VirtualKeyboardBenchmarks::refreshHeatMap_data() {
+    addRenderModeRows();
+}
+
+void VirtualKeyboardBenchmarks::refreshHeatMap() {
+    QFETCH(VirtualKeyboardWidget::RenderMode, renderMode);
+
+    VirtualKeyboardWidget keyboard;
+    prepareKeyboard(keyboard, renderMode);
+    QVERIFY(QTest::qWaitForWindowExposed(&keyboard));
+
+    // setHeatSamples 每次整表替换并触发一次完整的 refreshHeatMap
+    QHash<int, int> samples;
+    const QList<int> keys = sampleKeys();
+    for (int i = 0; i < keys.size(); ++i) {
+        samples.insert(keys.at(i), (i + 1) * 97);
+    }
+    int round = 0;
+    QBENCHMARK {
+        samples[Qt::Key_A] = 1000 + (++round % 2);
+        keyboard.setHeatSamples(samples);
+    }
+}
+
+void VirtualKeyboardBenchmarks::keyButtonPaint_data() {
+    QTest::addColumn<bool>("withPixmap");
+    QTest::newRow("plain") << false;
+    QTest::newRow("pixmap") << true;
+}
+
+void VirtualKeyboardBenchmarks::keyButtonPaint() {
+    QFETCH(bool, withPixmap);
+
+    KeyButton button(QStringLiteral("A"));
+    button.resize(64, 64);
+    button.setHeat(40, 100);
+    if (withPixmap) {
+        // 比键帽大得多的贴图，覆盖缩放缓存路径
+        QPixmap pixmap(512, 512);
+        pixmap.fill(QColor(60, 120, 200));
+        QPainter painter(&pixmap);
+        painter.fillRect(0, 0, 256, 256, QColor(200, 80, 40));
+        painter.end();
+        button.setBackgroundPixmap(pixmap);
+    }
+
+    // render 直接调用 paintEvent，不经过窗口系统
+    QPixmap target(button.size());
+    QBENCHMARK {
+        button.render(&target);
+    }
+}
+
+void VirtualKeyboardBenchmarks::construction() {
+    QBENCHMARK {
+        VirtualKeyboardWidget keyboard;
+        keyboard.setTrackPhysicalKeyboard(false);
+    }
+}
+
+void VirtualKeyboardBenchmarks::resizeAutoScale_data() {
+    addRenderModeRows();
+}
+
+void VirtualKeyboardBenchmarks::resizeAutoScale() {
+    QFETCH(VirtualKeyboardWidget::RenderMode, renderMode);
+
+    VirtualKeyboardWidget keyboard;
+    prepareKeyboard(keyboard, renderMode);
+    QVERIFY(QTest::qWaitForWindowExposed(&keyboard));
+
+    // 可见控件的 resize 同步派发 resizeEvent；字体自适应合并到下一帧，这里测量拖动缩放时单次事件的开销
+    const QSize sizes[] = {QSize(960, 320), QSize(1280, 420)};
+    int next = 0;
+    QBENCHMARK {
+        next = 1 - next;
+        keyboard.resize(sizes[next]);
+    }
+}
+
+void VirtualKeyboardBenchmarks::glowCpuMsPerSecond_data() {
+    addRenderModeRows();
+}
+
+void VirtualKeyboardBenchmarks::glowCpuMsPerSecond() {
+    QFETCH(VirtualKeyboardWidget::RenderMode, renderMode);
+
+    VirtualKeyboardWidget keyboard;
+    prepareKeyboard(keyboard, renderMode);
+    QVERIFY(QTest::qWaitForWindowExposed(&keyboard));
+
+    // 持续输入（每 50ms 一键）下运行事件循环 1 秒，统计进程 CPU 时间
+    const QList<int> keys = sampleKeys();
+    int next = 0;
+    QTimer typing;
+    typing.setInterval(50);
+    connect(&typing, &QTimer::timeout, &keyboard, [&]() {
+        keyboard.recordKey(keys.at(next));
+        next = (next + 1) % keys.size();
+    });
+
+    QBENCHMARK_ONCE {
+        const qreal cpuStart = processCpuMs();
+        QElapsedTimer wall;
+        wall.start();
+        typing.start();
+        QTest::qWait(1000);
+        typing.stop();
+        const qreal cpuMs = processCpuMs() - cpuStart;
+        // 结果是每秒墙钟时间消耗的 CPU 毫秒，不是耗时，因此不用 WalltimeMilliseconds；
+        // QTest 没有对应的度量，借用无量纲的 Events，JSON 报告中按函数名补上真实单位
+        QTest::setBenchmarkResult(cpuMs * 1000.0 / std::max<qint64>(1, wall.elapsed()), QTest::Events);
+    }
+}
+
+namespace {
+// 结果的实际单位：QTest 的度量名表达不了的在这里按基准函数名覆盖
+QString resultUnit(const QString &function, const QString &metric) {
+    if (function == QLatin1String("glowCpuMsPerSecond")) {
+        return QStringLiteral("cpu-ms/s");
+    }
+    if (metric == QLatin1String("WalltimeMilliseconds")) {
+        return QStringLiteral("ms");
+    }
+    if (metric == QLatin1String("WalltimeNanoseconds")) {
+        return QStringLiteral("ns");
+    }
+    if (metric == QLatin1String("CPUTicks")) {
+        return QStringLiteral("ticks");
+    }
+    return QStringLiteral("count");
+}
+
+// 把 QtTest XML 输出中的 BenchmarkResult 转成 JSON
+bool writeJsonReport(const QString &xmlPath, const QString &jsonPath) {
+    QFile xmlFile(xmlPath);
+    if (!xmlFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader xml(&xmlFile);
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("TestFunction")) {
+            function = attributes.value(QLatin1String("name")).toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject result;
+            result.insert(QStringLiteral("benchmark"), function);
+            result.insert(QStringLiteral("tag"), attributes.value(QLatin1String("tag")).toString());
+            const QString metric = attributes.value(QLatin1String("metric")).toString();
+            result.insert(QStringLiteral("metric"), metric);
+            result.insert(QStringLiteral("unit"), resultUnit(function, metric));
+            result.insert(QStringLiteral("value"), attributes.value(QLatin1String("value")).toDouble());
+            result.insert(QStringLiteral("iterations"), attributes.value(QLatin1String("iterations")).toInt());
+            results.append(result);
+        }
+    }
+    if (xml.hasError()) {
+        return false;
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("suite"), QStringLiteral("VirtualKeyboardBenchmarks"));
+    report.insert(QStringLiteral("qtVersion"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("platform"), QGuiApplication::platformName());
+    report.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert(QStringLiteral("results"), results);
+
+    QFile jsonFile(jsonPath);
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return jsonFile.write(QJsonDocument(report).toJson()) > 0;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // 默认使用 offscreen 平台，无显示环境（CI）也能运行
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    // --json <path> 由本程序处理，其余参数原样交给 QtTest
+    QStringList arguments = app.arguments();
+    QString jsonPath;
+    const int jsonIndex = arguments.indexOf(QStringLiteral("--json"));
+    if (jsonIndex >= 0 && jsonIndex + 1 < arguments.size()) {
+        jsonPath = arguments.at(jsonIndex + 1);
+        arguments.remove(jsonIndex, 2);
+    }
+
+    QTemporaryFile xmlFile;
+    if (!jsonPath.isEmpty()) {
+        // QtTest 自行打开输出文件，这里只占用一个临时文件名
+        if (!xmlFile.open()) {
+            return 1;
+        }
+        xmlFile.close();
+        arguments << QStringLiteral("-o") << xmlFile.fileName() + QStringLiteral(",xml")
+                  << QStringLiteral("-o") << QStringLiteral("-,txt");
+    }
+
+    VirtualKeyboardBenchmarks benchmarks;
+    const int status = QTest::qExec(&benchmarks, arguments);
+    if (!jsonPath.isEmpty() && !writeJsonReport(xmlFile.fileName(), jsonPath)) {
+        return status != 0 ? status : 1;
+    }
+    return status;
+}
+
+#include "VirtualKeyboardBenchmarks.moc"
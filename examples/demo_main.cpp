@@ -1,6 +1,8 @@
 #include <QApplication>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QMessageBox>
 #include <QMainWindow>
 #include <QPushButton>
 #include <QPainter>
@@ -39,13 +41,20 @@ public:
         info->setWordWrap(true);
         rightLayout->addWidget(info);
 
+        // 缩略视图与主键盘共享同一个统计模型：按键只捕获、计数一次，两个视图各自只重绘变化的键
+        auto *preview = new VirtualKeyboardWidget(rightPanel);
+        preview->setStatisticsModel(m_keyboard->statisticsModel());
+        preview->setRenderMode(VirtualKeyboardWidget::RenderMode::Batched);
+        preview->setHeatMode(VirtualKeyboardWidget::HeatMode::Decay); // 缩略图显示近期热度
+        preview->setHeatHalfLife(10000);
+        preview->setMinimumSize(360, 130);
+        rightLayout->addWidget(preview);
+
         auto *simulate = new QPushButton(tr("模拟按键"), rightPanel);
         connect(simulate, &QPushButton::clicked, this, [this]() {
-            // 通过 recordKey 手动注入多个按键，观察热力分布
+            // 通过 recordKeys 批量注入多个按键，只触发一次刷新，观察热力分布
             const QList<int> keys = {Qt::Key_A, Qt::Key_S, Qt::Key_D, Qt::Key_F, Qt::Key_Space};
-            for (int key : keys) {
-                m_keyboard->recordKey(key);
-            }
+            m_keyboard->recordKeys(keys);
         });
         rightLayout->addWidget(simulate);
 
@@ -72,6 +81,36 @@ public:
         });
         rightLayout->addWidget(toggleTexture);
 
+        auto *loadLayout = new QPushButton(tr("加载布局"), rightPanel);
+        connect(loadLayout, &QPushButton::clicked, this, [this]() {
+            // 布局示例见 examples/layouts，首次加载后会在旁边生成 .bin 缓存
+            const QString path = QFileDialog::getOpenFileName(this, tr("选择布局"), QString(), tr("布局 (*.json *.bin)"));
+            if (path.isEmpty()) {
+                return;
+            }
+            KeyboardLayout keyboardLayout;
+            if (!keyboardLayout.load(path)) {
+                QMessageBox::warning(this, tr("加载布局"), keyboardLayout.errorString());
+                return;
+            }
+            m_keyboard->setKeyboardLayout(keyboardLayout);
+        });
+        rightLayout->addWidget(loadLayout);
+
+        auto *exportImage = new QPushButton(tr("导出热力图"), rightPanel);
+        connect(exportImage, &QPushButton::clicked, this, [this]() {
+            // 无界面渲染：按当前外观放大两倍导出，不依赖控件在屏幕上的尺寸
+            const QString path = QFileDialog::getSaveFileName(this, tr("导出热力图"), QStringLiteral("heatmap.png"), tr("图片 (*.png)"));
+            if (path.isEmpty()) {
+                return;
+            }
+            HeatMapRenderOptions options = m_keyboard->heatMapRenderOptions();
+            options.devicePixelRatio = 2.0;
+            const HeatMapRenderer renderer(options);
+            renderer.render(m_keyboard->keyboardLayout(), m_keyboard->statisticsModel()->counts()).save(path);
+        });
+        rightLayout->addWidget(exportImage);
+
         auto *clear = new QPushButton(tr("清空统计"), rightPanel);
         connect(clear, &QPushButton::clicked, m_keyboard, &VirtualKeyboardWidget::clearStatistics);
         rightLayout->addWidget(clear);
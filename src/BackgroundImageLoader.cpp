@@ -0,0 +1,91 @@
+#include "BackgroundImageLoader.h"
+
+#include <QCoreApplication>
+#include <QImageReader>
+
+#include <utility>
+
+BackgroundImageLoader::BackgroundImageLoader(QObject *parent)
+    : QObject(parent) {
+    m_pool.setObjectName(QStringLiteral("BackgroundImageLoader"));
+}
+
+BackgroundImageLoader::~BackgroundImageLoader() {
+    cancelAll();
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+BackgroundImageLoader *BackgroundImageLoader::instance() {
+    static QPointer<BackgroundImageLoader> loader;
+    if (!loader) {
+        loader = new BackgroundImageLoader(QCoreApplication::instance());
+    }
+    return loader;
+}
+
+quint64 BackgroundImageLoader::load(const QString &path, const QSize &targetSize, QObject *context, Callback callback) {
+    const quint64 requestId = ++m_nextRequestId;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_pending.insert(requestId, PendingLoad {context, std::move(callback), cancelled});
+
+    m_pool.start([this, requestId, path, targetSize, cancelled]() {
+        // 排队期间已被取消则直接跳过解码
+        if (cancelled->load(std::memory_order_acquire)) {
+            return;
+        }
+        const QImage image = decode(path, targetSize);
+        if (cancelled->load(std::memory_order_acquire)) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, requestId, image]() {
+            finishLoad(requestId, image);
+        }, Qt::QueuedConnection);
+    });
+    return requestId;
+}
+
+void BackgroundImageLoader::cancel(quint64 requestId) {
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    it->cancelled->store(true, std::memory_order_release);
+    m_pending.erase(it);
+}
+
+void BackgroundImageLoader::cancelAll() {
+    for (const auto &pending : std::as_const(m_pending)) {
+        pending.cancelled->store(true, std::memory_order_release);
+    }
+    m_pending.clear();
+}
+
+QImage BackgroundImageLoader::decode(const QString &path, const QSize &targetSize) {
+    QImageReader reader(path);
+    // 目标尺寸已知且原图更大时，让解码器直接输出充满目标区域所需的最小尺寸（JPEG 等格式可跳过大部分像素）
+    if (targetSize.isValid() && !targetSize.isEmpty()) {
+        const QSize sourceSize = reader.size();
+        if (sourceSize.isValid()) {
+            const QSize fitted = sourceSize.scaled(targetSize, Qt::KeepAspectRatioByExpanding);
+            if (fitted.width() < sourceSize.width() && fitted.height() < sourceSize.height()) {
+                reader.setScaledSize(fitted);
+            }
+        }
+    }
+    QImage image = reader.read();
+    if (!image.isNull()) {
+        // 预先转换为绘制最快的格式，GUI 线程转 QPixmap 时无需再转换
+        image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+    return image;
+}
+
+void BackgroundImageLoader::finishLoad(quint64 requestId, const QImage &image) {
+    const PendingLoad pending = m_pending.take(requestId);
+    // 已取消或请求方已销毁时丢弃结果
+    if (!pending.callback || !pending.context) {
+        return;
+    }
+    pending.callback(image);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 键帽贴图异步加载器：在工作线程池中用 QImageReader 解码图片，
+// 尽量直接解码到目标尺寸，完成后回到 GUI 线程把结果交给请求方
+class BackgroundImageLoader : public QObject {
+    Q_OBJECT
+public:
+    // 解码完成回调，失败时 image 为空
+    using Callback = std::function<void(const QImage &image)>;
+
+    explicit BackgroundImageLoader(QObject *parent = nullptr);
+    // 析构时取消全部请求并等待正在解码的任务结束
+    ~BackgroundImageLoader() override;
+
+    // 进程内共享的加载器（挂在 QCoreApplication 下，仅在 GUI 线程调用）
+    static BackgroundImageLoader *instance();
+
+    // 提交一次加载，返回请求编号。targetSize 为键帽的设备像素尺寸，图片更大时解码阶段即缩小；
+    // 传入无效尺寸则按原图解码。context 销毁或请求被取消后不会再回调
+    quint64 load(const QString &path, const QSize &targetSize, QObject *context, Callback callback);
+    // 取消尚未完成的请求；未开始的任务会跳过解码
+    void cancel(quint64 requestId);
+    // 取消全部请求
+    void cancelAll();
+
+    // 解码函数本身，可在任意线程调用
+    static QImage decode(const QString &path, const QSize &targetSize);
+
+private:
+    // 在 GUI 线程中分发解码结果
+    void finishLoad(quint64 requestId, const QImage &image);
+
+    struct PendingLoad {
+        QPointer<QObject> context;
+        Callback callback;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    // 专用线程池，析构时可以安全地等待任务结束
+    QThreadPool m_pool;
+    // 未完成的请求
+    QHash<quint64, PendingLoad> m_pending;
+    quint64 m_nextRequestId {0};
+};
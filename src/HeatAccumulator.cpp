@@ -0,0 +1,121 @@
+#include "HeatAccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+void HeatAccumulator::setMode(Mode mode) {
+    if (mode == m_mode) {
+        return;
+    }
+    m_mode = mode;
+    clear();
+}
+
+void HeatAccumulator::setKeyCount(int count) {
+    m_states.resize(std::max(0, count));
+    clear();
+}
+
+void HeatAccumulator::remapKeys(const QVector<int> &newIndex, int count) {
+    QVector<KeyState> states(std::max(0, count));
+    for (int key = 0; key < m_states.size() && key < newIndex.size(); ++key) {
+        const int target = newIndex.at(key);
+        if (target >= 0 && target < states.size()) {
+            states[target] = m_states.at(key);
+        }
+    }
+    m_states = states;
+    m_windowActive = static_cast<int>(std::count_if(m_states.cbegin(), m_states.cend(), [](const KeyState &state) {
+        return state.windowTotal > 0;
+    }));
+}
+
+void HeatAccumulator::setHalfLife(qint64 halfLifeMs) {
+    m_halfLifeMs = std::max<qint64>(1, halfLifeMs);
+}
+
+void HeatAccumulator::setWindow(qint64 windowMs) {
+    windowMs = std::max<qint64>(WindowBuckets, windowMs);
+    if (windowMs == m_windowMs) {
+        return;
+    }
+    m_windowMs = windowMs;
+    if (m_mode == Mode::SlidingWindow) {
+        clear();
+    }
+}
+
+void HeatAccumulator::add(int key, int count, qint64 nowMs) {
+    if (count <= 0 || key < 0 || key >= m_states.size()) {
+        return;
+    }
+    KeyState &state = m_states[key];
+    if (m_mode == Mode::Decay) {
+        // 先把旧值衰减到当前时刻再累加，只动这一个键
+        state.decayed = value(key, nowMs) + count;
+        state.lastMs = nowMs;
+        return;
+    }
+
+    advanceWindow(state, nowMs / bucketWidth());
+    if (state.windowTotal == 0) {
+        ++m_windowActive;
+    }
+    state.buckets[state.lastBucket % WindowBuckets] += count;
+    state.windowTotal += count;
+}
+
+qreal HeatAccumulator::value(int key, qint64 nowMs) {
+    if (key < 0 || key >= m_states.size()) {
+        return 0.0;
+    }
+    KeyState &state = m_states[key];
+    if (m_mode == Mode::Decay) {
+        const qint64 elapsed = std::max<qint64>(0, nowMs - state.lastMs);
+        return state.decayed * std::exp2(-static_cast<qreal>(elapsed) / m_halfLifeMs);
+    }
+    advanceWindow(state, nowMs / bucketWidth());
+    return state.windowTotal;
+}
+
+qreal HeatAccumulator::decayed(qreal value, qint64 elapsedMs) const {
+    if (m_mode != Mode::Decay) {
+        return value;
+    }
+    return value * std::exp2(-static_cast<qreal>(std::max<qint64>(0, elapsedMs)) / m_halfLifeMs);
+}
+
+qreal HeatAccumulator::maxValue(qint64 nowMs) {
+    qreal maxValue = 0.0;
+    for (int key = 0; key < m_states.size(); ++key) {
+        maxValue = std::max(maxValue, value(key, nowMs));
+    }
+    return maxValue;
+}
+
+void HeatAccumulator::clear() {
+    m_states.fill(KeyState());
+    m_windowActive = 0;
+}
+
+void HeatAccumulator::advanceWindow(KeyState &state, qint64 bucket) {
+    if (bucket <= state.lastBucket) {
+        return;
+    }
+    const bool hadActivity = state.windowTotal > 0;
+    if (bucket - state.lastBucket >= WindowBuckets) {
+        // 整个窗口都已过期
+        state.buckets.fill(0);
+        state.windowTotal = 0;
+    } else {
+        for (qint64 b = state.lastBucket + 1; b <= bucket; ++b) {
+            int &expired = state.buckets[b % WindowBuckets];
+            state.windowTotal -= expired;
+            expired = 0;
+        }
+    }
+    state.lastBucket = bucket;
+    if (hadActivity && state.windowTotal == 0) {
+        --m_windowActive;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+
+// 按时间衰减或滑动窗口统计每个键的近期热度。
+// 每次按键 O(1)；衰减值只在读取时按时间戳折算，不需要定时遍历全部键。
+// 键以紧凑下标（0 ~ keyCount-1）寻址，状态连续存放
+class HeatAccumulator {
+public:
+    enum class Mode {
+        Decay,        // 指数衰减，halfLife 后权重减半
+        SlidingWindow // 最近 window 时长内的按键次数
+    };
+
+    // 滑动窗口划分的桶数，窗口边界精度为 window / WindowBuckets
+    static constexpr int WindowBuckets = 60;
+
+    int keyCount() const { return m_states.size(); }
+    // 设置可寻址的键数，已累计的热度清空
+    void setKeyCount(int count);
+    // 键集合变化：旧下标 i 的热度移到 newIndex[i]（-1 表示丢弃），键数变为 count
+    void remapKeys(const QVector<int> &newIndex, int count);
+
+    Mode mode() const { return m_mode; }
+    // 切换模式会清空已累计的热度
+    void setMode(Mode mode);
+
+    qint64 halfLife() const { return m_halfLifeMs; }
+    // 修改半衰期只影响之后的衰减，已累计值保留
+    void setHalfLife(qint64 halfLifeMs);
+
+    qint64 window() const { return m_windowMs; }
+    // 修改窗口长度会清空已累计的热度（桶宽随之改变）
+    void setWindow(qint64 windowMs);
+    // 单个桶覆盖的时长，窗口内计数按此粒度过期
+    qint64 bucketWidth() const { return std::max<qint64>(1, m_windowMs / WindowBuckets); }
+
+    // 在 nowMs 时刻为下标 key 的键记录 count 次按键
+    void add(int key, int count, qint64 nowMs);
+    // 读取 nowMs 时刻的热度（衰减值或窗口内次数）
+    qreal value(int key, qint64 nowMs);
+    // nowMs 时刻全部键热度的最大值
+    qreal maxValue(qint64 nowMs);
+    // 某一时刻的热度在 elapsedMs 之后的值：衰减模式下全部键按同一比例缩小，滑动窗口模式原样返回
+    qreal decayed(qreal value, qint64 elapsedMs) const;
+    // 滑动窗口内是否仍有未过期的按键
+    bool hasWindowActivity() const { return m_windowActive > 0; }
+
+    void clear();
+
+private:
+    struct KeyState {
+        qreal decayed {0.0};   // lastMs 时刻的衰减值
+        qint64 lastMs {0};
+        std::array<int, WindowBuckets> buckets {};
+        qint64 lastBucket {0}; // buckets 对应的最新桶序号（nowMs / bucketWidth）
+        int windowTotal {0};
+    };
+
+    // 把窗口推进到 bucket，清空其间过期的桶（最多 WindowBuckets 个）
+    void advanceWindow(KeyState &state, qint64 bucket);
+
+    Mode m_mode {Mode::Decay};
+    qint64 m_halfLifeMs {5 * 60 * 1000};
+    qint64 m_windowMs {60 * 1000};
+    QVector<KeyState> m_states;
+    int m_windowActive {0}; // 窗口计数非零的键数
+};
@@ -0,0 +1,90 @@
+#include "HeatGradient.h"
+
+#include <algorithm>
+#include <cmath>
+
+HeatGradient::HeatGradient(const QColor &cold, const QColor &hot)
+    : m_stops({{0.0, cold}, {1.0, hot}}) {
+    buildLut();
+}
+
+HeatGradient::HeatGradient(const QGradientStops &stops)
+    : m_stops(stops) {
+    std::sort(m_stops.begin(), m_stops.end(), [](const QGradientStop &a, const QGradientStop &b) {
+        return a.first < b.first;
+    });
+    buildLut();
+}
+
+HeatGradient HeatGradient::viridis() {
+    return HeatGradient(QGradientStops {
+        {0.000, QColor(0x44, 0x01, 0x54)}, {0.125, QColor(0x48, 0x28, 0x78)},
+        {0.250, QColor(0x3e, 0x49, 0x89)}, {0.375, QColor(0x31, 0x68, 0x8e)},
+        {0.500, QColor(0x26, 0x82, 0x8e)}, {0.625, QColor(0x1f, 0x9e, 0x89)},
+        {0.750, QColor(0x35, 0xb7, 0x79)}, {0.875, QColor(0x6e, 0xce, 0x58)},
+        {1.000, QColor(0xfd, 0xe7, 0x25)}
+    });
+}
+
+HeatGradient HeatGradient::inferno() {
+    return HeatGradient(QGradientStops {
+        {0.000, QColor(0x00, 0x00, 0x04)}, {0.125, QColor(0x1b, 0x0c, 0x41)},
+        {0.250, QColor(0x4a, 0x0c, 0x6b)}, {0.375, QColor(0x78, 0x1c, 0x6d)},
+        {0.500, QColor(0xa5, 0x2c, 0x60)}, {0.625, QColor(0xcf, 0x44, 0x46)},
+        {0.750, QColor(0xed, 0x69, 0x25)}, {0.875, QColor(0xfb, 0x9b, 0x06)},
+        {1.000, QColor(0xfc, 0xff, 0xa4)}
+    });
+}
+
+int HeatGradient::indexFor(qreal value, qreal maxValue) const {
+    if (value <= 0.0 || maxValue <= 0.0) {
+        return 0;
+    }
+    qreal factor = 0.0;
+    switch (m_scale) {
+    case Scale::Linear:
+        factor = value / maxValue;
+        break;
+    case Scale::Sqrt:
+        factor = std::sqrt(value / maxValue);
+        break;
+    case Scale::Log:
+        factor = std::log1p(value) / std::log1p(maxValue);
+        break;
+    }
+    return qBound(0, static_cast<int>(factor * (LutSize - 1)), LutSize - 1);
+}
+
+bool HeatGradient::operator==(const HeatGradient &other) const {
+    if (m_scale != other.m_scale) {
+        return false;
+    }
+    // 共享同一张表时不必逐项比较
+    return m_lut.constData() == other.m_lut.constData() || m_stops == other.m_stops;
+}
+
+void HeatGradient::buildLut() {
+    m_lut.resize(LutSize);
+    if (m_stops.isEmpty()) {
+        m_lut.fill(qRgb(0, 0, 0));
+        return;
+    }
+
+    // 相邻色标之间逐通道线性插值
+    int stop = 0;
+    for (int i = 0; i < LutSize; ++i) {
+        const qreal t = static_cast<qreal>(i) / (LutSize - 1);
+        while (stop + 1 < m_stops.size() && m_stops.at(stop + 1).first < t) {
+            ++stop;
+        }
+        const QGradientStop &from = m_stops.at(stop);
+        const QGradientStop &to = m_stops.at(std::min<int>(stop + 1, m_stops.size() - 1));
+        const qreal span = to.first - from.first;
+        const qreal factor = span > 0.0 ? qBound<qreal>(0.0, (t - from.first) / span, 1.0) : 0.0;
+        const QColor &a = from.second;
+        const QColor &b = to.second;
+        m_lut[i] = qRgb(static_cast<int>(a.red() + (b.red() - a.red()) * factor),
+                        static_cast<int>(a.green() + (b.green() - a.green()) * factor),
+                        static_cast<int>(a.blue() + (b.blue() - a.blue()) * factor));
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QColor>
+#include <QGradient>
+#include <QVector>
+
+// 热力图配色查找表：配色变化时一次性生成 LutSize 个颜色，
+// 拷贝只共享同一张表（隐式共享），绘制时取色只是一次数组下标访问
+class HeatGradient {
+public:
+    // 计数到颜色位置的映射方式
+    enum class Scale {
+        Linear, // count / max
+        Sqrt,   // sqrt(count / max)，抬高中低频键
+        Log     // log(1 + count) / log(1 + max)，适合长尾分布
+    };
+
+    static constexpr int LutSize = 1024;
+
+    // 冷色到热色的两段线性渐变
+    HeatGradient(const QColor &cold = QColor(30, 35, 45), const QColor &hot = QColor(102, 170, 255));
+    // 多段渐变，stops 的位置取值 0~1
+    explicit HeatGradient(const QGradientStops &stops);
+
+    // 感知均匀配色（采样自 matplotlib 同名配色）
+    static HeatGradient viridis();
+    static HeatGradient inferno();
+
+    const QGradientStops &stops() const { return m_stops; }
+
+    Scale scale() const { return m_scale; }
+    void setScale(Scale scale) { m_scale = scale; }
+
+    // 按当前映射方式把热度（计数或衰减值）换算为查找表下标，仅在热度或最大值变化时调用
+    int indexFor(qreal value, qreal maxValue) const;
+    // 查表取色
+    QRgb colorAt(int index) const { return m_lut.at(qBound(0, index, LutSize - 1)); }
+
+    // 查找表与映射方式均相同（拷贝自同一对象时无需比较颜色）
+    bool operator==(const HeatGradient &other) const;
+    bool operator!=(const HeatGradient &other) const { return !(*this == other); }
+
+private:
+    // 按 m_stops 生成查找表
+    void buildLut();
+
+    QGradientStops m_stops;
+    QVector<QRgb> m_lut;
+    Scale m_scale {Scale::Linear};
+};
@@ -0,0 +1,114 @@
+#include "HeatMapRenderer.h"
+
+#include "KeyPainter.h"
+
+#include <QPainter>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+
+HeatMapRenderer::HeatMapRenderer(const HeatMapRenderOptions &options)
+    : m_options(options) {
+}
+
+QImage HeatMapRenderer::render(const KeyboardLayout &layout, const QHash<int, int> &counts) const {
+    const qreal dpr = std::max<qreal>(m_options.devicePixelRatio, 0.01);
+    QImage image((QSizeF(m_options.size) * dpr).toSize(), QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        return image;
+    }
+    image.setDevicePixelRatio(dpr);
+    const int dotsPerMeter = qRound(std::max(m_options.logicalDpi, 1) / 0.0254);
+    image.setDotsPerMeterX(dotsPerMeter);
+    image.setDotsPerMeterY(dotsPerMeter);
+    image.fill(m_options.backgroundColor);
+    // 每张图各自一个 QPainter，可在多个线程中同时渲染
+    QPainter painter(&image);
+    paint(painter, layout, counts);
+    return image;
+}
+
+void HeatMapRenderer::paint(QPainter &painter, const KeyboardLayout &layout, const QHash<int, int> &counts) const {
+    if (layout.isEmpty()) {
+        return;
+    }
+    const int rowCount = layout.rowCount();
+    const int columnCount = layout.columnCount();
+    const QVector<KeyboardLayout::Key> &keys = layout.keys();
+
+    // 与控件累计模式的 refreshHeatMap 相同：以布局内最大计数归一化，最大值至少为 1
+    qreal maxHeat = 1.0;
+    for (const KeyboardLayout::Key &key : keys) {
+        maxHeat = std::max<qreal>(maxHeat, counts.value(key.qtKey));
+    }
+
+    QFont font = m_options.font;
+    if (m_options.autoScaleContent) {
+        font.setPixelSize(KeyPainter::autoScalePixelSize(m_options.size.height(), rowCount, m_options.margins,
+                                                         m_options.spacing));
+    }
+
+    KeyCapStyle style;
+    style.highlightColor = m_options.highlightColor;
+    style.textColor = m_options.textColor;
+
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    const QPaintDevice &device = *painter.device();
+    const QRect area = QRect(QPoint(0, 0), m_options.size).marginsRemoved(m_options.margins);
+    for (const KeyboardLayout::Key &key : keys) {
+        const QRectF rect = KeyPainter::gridCellRect(area, m_options.spacing, rowCount, columnCount, key.row,
+                                                     key.column, key.rowSpan, key.columnSpan);
+        const qreal heat = m_options.heatMapEnabled ? counts.value(key.qtKey) : 0.0;
+        KeyCapState state;
+        state.heatColor = QColor::fromRgb(m_options.gradient.colorAt(m_options.gradient.indexFor(heat, maxHeat)));
+        // 与控件相同：先生成键帽静态层再合成动态部分，保证逐像素一致
+        KeyCapLayer layer;
+        KeyPainter::updateKeyCapLayer(layer, device, rect, key.label, font, style.textColor,
+                                      m_options.keyBackgrounds.value(key.qtKey));
+        KeyPainter::paintKey(painter, layer, style, state);
+    }
+    painter.restore();
+}
+
+QVector<QImage> HeatMapRenderer::renderBatch(const QVector<Job> &jobs, QThreadPool *pool) const {
+    QVector<QImage> images(jobs.size());
+    // 每个任务只写自己的元素，事先取出数据指针避免在工作线程中触发分离
+    QImage *results = images.data();
+    renderBatch(jobs, [results](int index, const QImage &image) { results[index] = image; }, pool);
+    return images;
+}
+
+void HeatMapRenderer::renderBatch(const QVector<Job> &jobs, const Sink &sink, QThreadPool *pool) const {
+    if (jobs.isEmpty()) {
+        return;
+    }
+    if (!pool) {
+        pool = QThreadPool::globalInstance();
+    }
+
+    // 工作线程与调用线程从同一个原子计数器领取任务；只借用线程池中当前空闲的线程，
+    // 线程池繁忙（或在池内任务中调用）时由调用线程独自完成，不会互相等待
+    std::atomic<int> next {0};
+    const auto work = [this, &jobs, &sink, &next]() {
+        for (int index = next++; index < jobs.size(); index = next++) {
+            sink(index, render(jobs.at(index).layout, jobs.at(index).counts));
+        }
+    };
+    QSemaphore finished;
+    int helpers = 0;
+    const int wanted = static_cast<int>(std::min<qsizetype>(jobs.size(), pool->maxThreadCount())) - 1;
+    for (; helpers < wanted; ++helpers) {
+        const bool started = pool->tryStart([&work, &finished]() {
+            work();
+            finished.release();
+        });
+        if (!started) {
+            break;
+        }
+    }
+    work();
+    finished.acquire(helpers);
+}
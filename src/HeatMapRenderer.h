@@ -0,0 +1,66 @@
+#pragma once
+
+#include "HeatGradient.h"
+#include "KeyboardLayout.h"
+
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QMargins>
+#include <QSize>
+#include <QVector>
+
+#include <functional>
+
+class QPainter;
+class QThreadPool;
+
+// 无界面渲染参数，默认值与 VirtualKeyboardWidget 的默认外观一致
+struct HeatMapRenderOptions {
+    QSize size {980, 300};             // 逻辑尺寸
+    qreal devicePixelRatio {1.0};      // 设备像素比，输出图像为 size × devicePixelRatio 像素
+    int logicalDpi {96};               // 输出图像的逻辑 DPI，决定点数字号的像素大小
+    HeatGradient gradient {QColor(18, 26, 38), QColor(126, 192, 255)}; // 配色与映射方式
+    bool heatMapEnabled {true};        // 关闭时全部键取最冷色
+    QFont font {QStringLiteral("Inter"), 10}; // 键帽字体
+    bool autoScaleContent {true};      // 按高度自适应字体像素大小
+    QColor highlightColor {QColor(255, 65, 130)};
+    QColor textColor {Qt::white};
+    QColor backgroundColor {Qt::transparent}; // 键帽之外的底色
+    QMargins margins {6, 6, 6, 6};     // 与控件网格布局的边距、间距相同
+    int spacing {4};
+    QHash<int, QImage> keyBackgrounds; // 键帽贴图（Qt::Key -> 图像）
+};
+
+// 无界面热力图渲染器：按布局与累计计数直接绘制到 QImage，不创建任何 QWidget，可在任意线程使用。
+// 网格、字体缩放与键帽绘制和 VirtualKeyboardWidget 的批量渲染模式共用同一套函数，相同参数下逐像素一致
+class HeatMapRenderer {
+public:
+    // 一个批量渲染任务（如一位用户的布局与计数）
+    struct Job {
+        KeyboardLayout layout;
+        QHash<int, int> counts; // Qt::Key -> 累计次数
+    };
+    // 批量渲染的结果回调，在工作线程中调用（可直接保存文件），index 为任务下标
+    using Sink = std::function<void(int index, const QImage &image)>;
+
+    explicit HeatMapRenderer(const HeatMapRenderOptions &options = HeatMapRenderOptions());
+
+    const HeatMapRenderOptions &options() const { return m_options; }
+    void setOptions(const HeatMapRenderOptions &options) { m_options = options; }
+
+    // 渲染一张热力图
+    QImage render(const KeyboardLayout &layout, const QHash<int, int> &counts) const;
+    // 绘制到调用方的 painter（逻辑坐标，区域为 options().size）
+    void paint(QPainter &painter, const KeyboardLayout &layout, const QHash<int, int> &counts) const;
+
+    // 在线程池中并行渲染，每个工作线程用自己的 QPainter 绘制各自的 QImage，阻塞到全部完成。
+    // pool 为空时使用全局线程池
+    QVector<QImage> renderBatch(const QVector<Job> &jobs, QThreadPool *pool = nullptr) const;
+    // 同上，但结果逐张交给 sink 而不在内存中保留，适合数量很多的离线报告
+    void renderBatch(const QVector<Job> &jobs, const Sink &sink, QThreadPool *pool = nullptr) const;
+
+private:
+    HeatMapRenderOptions m_options;
+};
@@ -0,0 +1,373 @@
+#include "HeatStatisticsStore.h"
+
+#include <QDir>
+#include <QSaveFile>
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+constexpr char SnapshotMagic[4] = {'E', 'K', 'B', 'S'};
+constexpr char JournalMagic[4] = {'E', 'K', 'B', 'J'};
+constexpr quint16 FormatVersion = 1;
+constexpr int SnapshotHeaderSize = 24;
+constexpr int JournalHeaderSize = 16;
+constexpr int BatchHeaderSize = 8;
+constexpr int EntrySize = 8;
+// 日志头标志：首个批次是整体替换后的完整计数，快照与更早的日志全部作废
+constexpr quint16 JournalResetFlag = 0x1;
+
+QString snapshotFileName() {
+    return QStringLiteral("snapshot.bin");
+}
+
+QString journalFileName(quint64 generation) {
+    return QStringLiteral("journal-%1.bin").arg(generation, 16, 16, QLatin1Char('0'));
+}
+
+// 从文件名解析日志代号，不是日志文件时返回 false
+bool parseJournalGeneration(const QString &fileName, quint64 *generation) {
+    if (!fileName.startsWith(QLatin1String("journal-")) || !fileName.endsWith(QLatin1String(".bin"))) {
+        return false;
+    }
+    bool ok = false;
+    *generation = fileName.mid(8, fileName.size() - 12).toULongLong(&ok, 16);
+    return ok;
+}
+
+int saturatedAdd(int a, int b) {
+    return static_cast<int>(std::clamp<qint64>(static_cast<qint64>(a) + b, 0, std::numeric_limits<int>::max()));
+}
+
+QByteArray encodeEntries(const QHash<int, int> &counts) {
+    QByteArray bytes(counts.size() * EntrySize, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(bytes.data());
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it, out += EntrySize) {
+        qToLittleEndian<qint32>(it.key(), out);
+        qToLittleEndian<qint32>(it.value(), out + 4);
+    }
+    return bytes;
+}
+
+// 解码条目并累加到 counts
+void applyEntries(const uchar *data, quint32 entryCount, QHash<int, int> *counts) {
+    for (quint32 i = 0; i < entryCount; ++i, data += EntrySize) {
+        int &value = (*counts)[qFromLittleEndian<qint32>(data)];
+        value = saturatedAdd(value, qFromLittleEndian<qint32>(data + 4));
+    }
+}
+
+// 读取快照，返回其已并入的日志代号；文件不存在或损坏时 counts 保持为空并返回 0
+quint64 readSnapshot(const QString &path, QHash<int, int> *counts) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QByteArray bytes = file.readAll();
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    if (bytes.size() < SnapshotHeaderSize || std::memcmp(data, SnapshotMagic, sizeof(SnapshotMagic)) != 0
+        || qFromLittleEndian<quint16>(data + 4) != FormatVersion) {
+        return 0;
+    }
+    const quint64 generation = qFromLittleEndian<quint64>(data + 8);
+    const quint32 entryCount = qFromLittleEndian<quint32>(data + 16);
+    const quint32 checksum = qFromLittleEndian<quint32>(data + 20);
+    const QByteArrayView entries(bytes.constData() + SnapshotHeaderSize, bytes.size() - SnapshotHeaderSize);
+    if (entries.size() != static_cast<qsizetype>(entryCount) * EntrySize || qChecksum(entries) != checksum) {
+        return 0;
+    }
+    counts->reserve(entryCount);
+    applyEntries(data + SnapshotHeaderSize, entryCount, counts);
+    return generation;
+}
+
+// 把完整计数原子地写成快照，可在工作线程调用
+bool writeSnapshot(const QString &path, const QHash<int, int> &counts, quint64 generation) {
+    const QByteArray entries = encodeEntries(counts);
+    uchar header[SnapshotHeaderSize] = {};
+    std::memcpy(header, SnapshotMagic, sizeof(SnapshotMagic));
+    qToLittleEndian<quint16>(FormatVersion, header + 4);
+    qToLittleEndian<quint64>(generation, header + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(counts.size()), header + 16);
+    qToLittleEndian<quint32>(qChecksum(entries), header + 20);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(entries);
+    return file.commit();
+}
+
+// 按批次重放一个日志文件，遇到不完整或校验失败的批次（写入中途崩溃）即停止。
+// 重置日志的首个批次完整时先清空 counts；首个批次不完整说明重置未落盘，之前的计数保留
+void replayJournal(const QString &path, QHash<int, int> *counts) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < JournalHeaderSize) {
+        return;
+    }
+    const qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+    if (!data || std::memcmp(data, JournalMagic, sizeof(JournalMagic)) != 0
+        || qFromLittleEndian<quint16>(data + 4) != FormatVersion) {
+        return;
+    }
+    const bool resetJournal = qFromLittleEndian<quint16>(data + 6) & JournalResetFlag;
+    qint64 offset = JournalHeaderSize;
+    while (offset + BatchHeaderSize <= size) {
+        const quint32 entryCount = qFromLittleEndian<quint32>(data + offset);
+        const quint32 checksum = qFromLittleEndian<quint32>(data + offset + 4);
+        const qint64 batchBytes = static_cast<qint64>(entryCount) * EntrySize;
+        const uchar *entries = data + offset + BatchHeaderSize;
+        if (offset + BatchHeaderSize + batchBytes > size
+            || qChecksum(QByteArrayView(entries, batchBytes)) != checksum) {
+            break;
+        }
+        if (resetJournal && offset == JournalHeaderSize) {
+            // 整体替换：丢弃之前累加的计数，首个批次即完整计数
+            counts->clear();
+        }
+        applyEntries(entries, entryCount, counts);
+        offset += BatchHeaderSize + batchBytes;
+    }
+}
+
+// 把已 flush 的内容落到磁盘（fsync），断电或系统崩溃后仍然存在
+bool syncToDisk(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()))) != 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+// 删除代号不超过 generation 的日志
+void removeJournals(const QString &directory, quint64 generation) {
+    QDir dir(directory);
+    const QStringList names = dir.entryList({QStringLiteral("journal-*.bin")}, QDir::Files);
+    for (const QString &name : names) {
+        quint64 journalGeneration = 0;
+        if (parseJournalGeneration(name, &journalGeneration) && journalGeneration <= generation) {
+            dir.remove(name);
+        }
+    }
+}
+} // namespace
+
+HeatStatisticsStore::HeatStatisticsStore(QObject *parent)
+    : QObject(parent) {
+    // 同一时刻只做一次压缩，保证快照按代号顺序落盘
+    m_compactionPool.setMaxThreadCount(1);
+    m_compactionPool.setObjectName(QStringLiteral("HeatStatisticsStore"));
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(1000);
+    connect(&m_flushTimer, &QTimer::timeout, this, &HeatStatisticsStore::flush);
+}
+
+HeatStatisticsStore::~HeatStatisticsStore() {
+    close();
+}
+
+bool HeatStatisticsStore::open(const QString &directory, QHash<int, int> *counts) {
+    close();
+    QDir dir(directory);
+    if (!dir.mkpath(QStringLiteral("."))) {
+        m_error = QStringLiteral("cannot create statistics directory %1").arg(directory);
+        return false;
+    }
+    m_directory = dir.absolutePath();
+
+    // 快照 + 代号更新的日志，按代号顺序重放
+    QHash<int, int> loaded;
+    const quint64 snapshotGeneration = readSnapshot(dir.filePath(snapshotFileName()), &loaded);
+    QList<quint64> journals;
+    const QStringList names = dir.entryList({QStringLiteral("journal-*.bin")}, QDir::Files);
+    for (const QString &name : names) {
+        quint64 generation = 0;
+        if (parseJournalGeneration(name, &generation) && generation > snapshotGeneration) {
+            journals.append(generation);
+        }
+    }
+    std::sort(journals.begin(), journals.end());
+    // 重置日志清空之前的计数，因此按代号顺序重放即可得到最后一次重置之后的结果
+    for (quint64 generation : std::as_const(journals)) {
+        replayJournal(dir.filePath(journalFileName(generation)), &loaded);
+    }
+
+    // 计数为 0 的键不必保留
+    loaded.removeIf([](QHash<int, int>::iterator it) { return it.value() <= 0; });
+    m_counts = loaded;
+    m_generation = journals.isEmpty() ? snapshotGeneration : journals.last();
+    if (!journals.isEmpty()) {
+        // 把重放过的日志并入新快照，启动路径本身不写快照
+        scheduleSnapshot();
+    } else if (!openJournal(m_generation + 1)) {
+        return false;
+    }
+    if (!m_journal.isOpen()) {
+        return false;
+    }
+    if (counts) {
+        *counts = loaded;
+    }
+    m_error.clear();
+    return true;
+}
+
+void HeatStatisticsStore::close() {
+    if (m_journal.isOpen()) {
+        flush();
+        m_journal.close();
+    }
+    m_flushTimer.stop();
+    m_pending.clear();
+    waitForCompaction();
+}
+
+void HeatStatisticsStore::append(int qtKey, int delta) {
+    if (!m_journal.isOpen() || delta == 0) {
+        return;
+    }
+    int &pending = m_pending[qtKey];
+    pending = saturatedAdd(pending, delta);
+    int &total = m_counts[qtKey];
+    total = saturatedAdd(total, delta);
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void HeatStatisticsStore::flush() {
+    m_flushTimer.stop();
+    if (m_pending.isEmpty() || !m_journal.isOpen()) {
+        return;
+    }
+    const QHash<int, int> pending = std::exchange(m_pending, {});
+    if (!writeBatch(pending)) {
+        emit writeFailed(m_error);
+        return;
+    }
+    if (m_journal.size() > m_compactionThreshold) {
+        compact();
+    }
+}
+
+bool HeatStatisticsStore::reset(const QHash<int, int> &counts) {
+    if (!m_journal.isOpen()) {
+        return false;
+    }
+    // 整体替换时之前的增量全部作废。新计数作为重置日志的首个批次写出并 fsync，返回时已在磁盘上，
+    // 此后进程、系统崩溃或断电都不会重放旧快照与旧日志；每次重置只同步一次，逐键增量仍不做 fsync。
+    // 合成快照仍在后台完成
+    m_pending.clear();
+    m_flushTimer.stop();
+    m_counts = counts;
+    m_counts.removeIf([](QHash<int, int>::iterator it) { return it.value() <= 0; });
+    if (!openJournal(m_generation + 1, JournalResetFlag)) {
+        emit writeFailed(m_error);
+        return false;
+    }
+    bool written = writeBatch(m_counts);
+    if (written && !syncToDisk(m_journal)) {
+        m_error = QStringLiteral("cannot sync %1 to disk").arg(m_journal.fileName());
+        written = false;
+    }
+    if (!written) {
+        // 重置批次不完整时不能继续追加，否则后续增量批次会被当成完整计数重放
+        m_journal.close();
+        emit writeFailed(m_error);
+        return false;
+    }
+    scheduleSnapshot();
+    return true;
+}
+
+void HeatStatisticsStore::compact() {
+    if (!m_journal.isOpen()) {
+        return;
+    }
+    flush();
+    scheduleSnapshot();
+}
+
+void HeatStatisticsStore::waitForCompaction() {
+    m_compactionPool.waitForDone();
+}
+
+void HeatStatisticsStore::setFlushInterval(int intervalMs) {
+    m_flushTimer.setInterval(std::max(0, intervalMs));
+}
+
+bool HeatStatisticsStore::openJournal(quint64 generation, quint16 flags) {
+    if (m_journal.isOpen()) {
+        m_journal.close();
+    }
+    m_journal.setFileName(QDir(m_directory).filePath(journalFileName(generation)));
+    if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_journal.errorString();
+        return false;
+    }
+    uchar header[JournalHeaderSize] = {};
+    std::memcpy(header, JournalMagic, sizeof(JournalMagic));
+    qToLittleEndian<quint16>(FormatVersion, header + 4);
+    qToLittleEndian<quint16>(flags, header + 6);
+    qToLittleEndian<quint64>(generation, header + 8);
+    if (m_journal.write(reinterpret_cast<const char *>(header), sizeof(header)) != sizeof(header)) {
+        m_error = m_journal.errorString();
+        m_journal.close();
+        return false;
+    }
+    m_generation = generation;
+    return true;
+}
+
+bool HeatStatisticsStore::writeBatch(const QHash<int, int> &entries) {
+    // 一批条目拼成一次写入：批次头 + 条目，重放时按校验和识别写了一半的批次
+    const QByteArray bytes = encodeEntries(entries);
+    uchar header[BatchHeaderSize];
+    qToLittleEndian<quint32>(static_cast<quint32>(entries.size()), header);
+    qToLittleEndian<quint32>(qChecksum(bytes), header + 4);
+    QByteArray batch(reinterpret_cast<const char *>(header), sizeof(header));
+    batch += bytes;
+    if (m_journal.write(batch) != batch.size() || !m_journal.flush()) {
+        m_error = m_journal.errorString();
+        return false;
+    }
+    return true;
+}
+
+void HeatStatisticsStore::scheduleSnapshot() {
+    // 之后的增量写入新代号日志；快照覆盖到上一代为止，写好后才删除旧日志，
+    // 快照落盘前崩溃时旧日志仍在，下次打开照常重放
+    const quint64 covered = m_generation;
+    if (!openJournal(covered + 1)) {
+        return;
+    }
+    const QString directory = m_directory;
+    const QHash<int, int> counts = m_counts;
+    m_compactionPool.start([this, directory, counts, covered]() {
+        const bool success = writeSnapshot(QDir(directory).filePath(snapshotFileName()), counts, covered);
+        if (success) {
+            removeJournals(directory, covered);
+        }
+        QMetaObject::invokeMethod(this, [this, success]() {
+            emit compacted(success);
+        }, Qt::QueuedConnection);
+    });
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+// 热力统计持久化：紧凑二进制快照 + 只追加的增量日志。
+// 增量先在内存中按键合并，定时整批写入日志（每批一次写入与 flush，而不是每键一次）；
+// 打开时读取快照并重放日志尾部，压缩（写新快照、删除已并入的日志）在后台线程完成。
+//
+// 目录内文件（小端）：
+//   snapshot.bin            magic "EKBS" | quint16 版本 | 2 字节保留 | quint64 已并入的日志代号
+//                           | quint32 条目数 | quint32 校验和 | 条目 (qint32 Qt::Key, qint32 计数)
+//   journal-<代号>.bin      magic "EKBJ" | quint16 版本 | quint16 标志 | quint64 代号
+//                           | 批次 (quint32 条目数, quint32 校验和, 条目 (qint32 Qt::Key, qint32 增量))
+// 每次压缩切换到新代号的日志文件，快照用 QSaveFile 原子替换，任意时刻崩溃都能恢复到最后一个完整批次。
+// reset 写出带重置标志的日志，其首个批次是完整计数，重放到这里时丢弃快照与更早日志的计数
+class HeatStatisticsStore : public QObject {
+    Q_OBJECT
+public:
+    explicit HeatStatisticsStore(QObject *parent = nullptr);
+    // 析构时写出未落盘的增量并等待后台压缩结束
+    ~HeatStatisticsStore() override;
+
+    // 打开（必要时创建）存储目录，把快照与日志中的计数读入 counts；
+    // 重放过日志时在后台压缩
+    bool open(const QString &directory, QHash<int, int> *counts);
+    void close();
+    bool isOpen() const { return m_journal.isOpen(); }
+    QString directory() const { return m_directory; }
+    QString errorString() const { return m_error; }
+
+    // 记录一次计数增量，按 flushInterval 批量写入日志
+    void append(int qtKey, int delta);
+    // 立即写出本批增量
+    void flush();
+    // 以 counts 整体替换已存储的统计（如 setHeatSamples / clearStatistics），返回前已写入日志并 fsync。
+    // 失败时返回 false 并发出 writeFailed，存储随之关闭（isOpen() 为 false），之后的增量不再写入
+    bool reset(const QHash<int, int> &counts);
+    // 把当前统计写成新快照并清理旧日志（后台执行）
+    void compact();
+    // 等待正在进行的后台压缩
+    void waitForCompaction();
+
+    int flushInterval() const { return m_flushTimer.interval(); }
+    // 增量批量写入的间隔（毫秒）
+    void setFlushInterval(int intervalMs);
+
+    qint64 compactionThreshold() const { return m_compactionThreshold; }
+    // 当前日志超过该字节数时自动压缩
+    void setCompactionThreshold(qint64 bytes) { m_compactionThreshold = bytes; }
+
+    // 当前日志文件大小
+    qint64 journalBytes() const { return m_journal.isOpen() ? m_journal.size() : 0; }
+
+signals:
+    // 一次后台压缩结束
+    void compacted(bool success);
+    // 增量批次或重置写入失败，errorString 同 errorString()
+    void writeFailed(const QString &errorString);
+
+private:
+    // 开启指定代号的新日志文件，flags 写入日志头
+    bool openJournal(quint64 generation, quint16 flags = 0);
+    // 把一批条目追加到当前日志并 flush
+    bool writeBatch(const QHash<int, int> &entries);
+    // 切换到新代号日志并在后台把 m_counts 写成快照
+    void scheduleSnapshot();
+
+    QString m_directory;
+    QString m_error;
+    QFile m_journal;
+    quint64 m_generation {0};
+    QHash<int, int> m_counts;  // 与已写入内容一致的完整计数，压缩时直接生成快照
+    QHash<int, int> m_pending; // 本批尚未写出的增量
+    QTimer m_flushTimer;
+    qint64 m_compactionThreshold {4 * 1024 * 1024};
+    QThreadPool m_compactionPool;
+};
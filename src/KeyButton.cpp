@@ -1,10 +1,14 @@
 #include "KeyButton.h"
 
+#include "BackgroundImageLoader.h"
+#include "KeyPainter.h"
+
 #include <QColor>
 #include <QPainter>
-#include <QPainterPath>
 #include <QPaintEvent>
-#include <QStyle>
+#include <QPropertyAnimation>
+
+#include <utility>
 
 KeyButton::KeyButton(const QString &text, QWidget *parent)
     : QPushButton(text, parent) {
@@ -12,49 +16,92 @@ KeyButton::KeyButton(const QString &text, QWidget *parent)
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     setCheckable(false);
     setMinimumSize(32, 32);
-    // 设置渐隐计时器频率
-    m_glowTimer.setInterval(30);
-    connect(&m_glowTimer, &QTimer::timeout, this, &KeyButton::onFadeStep);
-    updateVisualState();
+    // 按下/释放时重绘边框
+    connect(this, &QPushButton::pressed, this, &KeyButton::updateVisualState);
+    connect(this, &QPushButton::released, this, &KeyButton::updateVisualState);
 }
 
 void KeyButton::triggerGlow(int durationMs) {
-    Q_UNUSED(durationMs);
-    // 重置高亮强度并开启渐隐计时
-    m_glowLevel = 1.0;
-    m_glowTimer.start();
-    updateVisualState();
+    if (!m_glowAnimation) {
+        m_glowAnimation = new QPropertyAnimation(this, "glowLevel", this);
+        m_glowAnimation->setEndValue(0.0);
+    }
+    // 从满亮度开始，按指定时长线性渐隐
+    m_glowAnimation->stop();
+    m_glowAnimation->setDuration(qMax(1, durationMs));
+    m_glowAnimation->setStartValue(1.0);
+    m_glowAnimation->start();
 }
 
-void KeyButton::setHeat(int count, int maxCount) {
-    // 记录当前键计数与全局最大计数
-    m_heat = count;
-    m_heatMax = qMax(1, maxCount);
+void KeyButton::setHeat(qreal heat, qreal maxHeat) {
+    // 记录当前键热度与全局最大值，未变化时不重绘
+    if (maxHeat <= 0.0) {
+        maxHeat = 1.0;
+    }
+    if (heat == m_heat && maxHeat == m_heatMax) {
+        return;
+    }
+    m_heat = heat;
+    m_heatMax = maxHeat;
+    m_heatIndex = m_heatGradient.indexFor(m_heat, m_heatMax);
     updateVisualState();
 }
 
 void KeyButton::setHeatColors(const QColor &cold, const QColor &hot) {
+    if (cold == m_coldColor && hot == m_hotColor) {
+        return;
+    }
     m_coldColor = cold;
     m_hotColor = hot;
+    HeatGradient gradient(cold, hot);
+    gradient.setScale(m_heatGradient.scale());
+    setHeatGradient(gradient);
+}
+
+void KeyButton::setHeatGradient(const HeatGradient &gradient) {
+    if (gradient == m_heatGradient) {
+        return;
+    }
+    const bool rescale = gradient.scale() != m_heatGradient.scale();
+    m_heatGradient = gradient;
+    if (rescale) {
+        m_heatIndex = m_heatGradient.indexFor(m_heat, m_heatMax);
+    }
     updateVisualState();
 }
 
 void KeyButton::setHighlightColor(const QColor &color) {
+    if (color == m_highlightColor) {
+        return;
+    }
     m_highlightColor = color;
     updateVisualState();
 }
 
 void KeyButton::setBaseTextColor(const QColor &color) {
+    if (color == m_textColor) {
+        return;
+    }
     m_textColor = color;
+    m_keyCapLayer.invalidate();
     updateVisualState();
 }
 
+KeyButton::~KeyButton() {
+    cancelBackgroundLoad();
+}
+
 void KeyButton::setBackgroundPixmap(const QPixmap &pixmap) {
-    if (pixmap.cacheKey() == m_backgroundPixmap.cacheKey()) {
+    // 直接指定图片时放弃尚未完成的路径加载
+    cancelBackgroundLoad();
+    if (pixmap.cacheKey() == m_backgroundPixmap.cacheKey() && !m_atlasPage) {
         return;
     }
     // 设置背景图片，同时保持路径字符串一致性
     m_backgroundPixmap = pixmap;
+    m_atlasPage.reset();
+    m_backgroundRect = QRect();
+    m_keyCapLayer.invalidate();
     if (m_backgroundImagePath.isEmpty()) {
         m_backgroundImagePath = QString();
         emit backgroundImagePathChanged(m_backgroundImagePath);
@@ -63,18 +110,57 @@ void KeyButton::setBackgroundPixmap(const QPixmap &pixmap) {
     emit backgroundPixmapChanged(m_backgroundPixmap);
 }
 
+void KeyButton::setBackgroundRegion(std::shared_ptr<const QPixmap> atlasPage, const QRect &sourceRect) {
+    if (!atlasPage || !sourceRect.isValid()) {
+        setBackgroundPixmap(QPixmap());
+        return;
+    }
+    cancelBackgroundLoad();
+    // 页面写入新贴图时内容会变，但已有子区域不变，按页面对象与子区域判断是否相同
+    if (atlasPage == m_atlasPage && sourceRect == m_backgroundRect) {
+        return;
+    }
+    m_backgroundPixmap = QPixmap();
+    m_atlasPage = std::move(atlasPage);
+    m_backgroundRect = sourceRect;
+    m_keyCapLayer.invalidate();
+    updateVisualState();
+    emit backgroundPixmapChanged(m_backgroundPixmap);
+}
+
 void KeyButton::setBackgroundImagePath(const QString &path) {
     if (path == m_backgroundImagePath) {
         return;
     }
     m_backgroundImagePath = path;
-    QPixmap pixmap(path);
-    if (!pixmap.isNull()) {
-        m_backgroundPixmap = pixmap;
-        emit backgroundPixmapChanged(m_backgroundPixmap);
-    }
-    updateVisualState();
+    cancelBackgroundLoad();
     emit backgroundImagePathChanged(m_backgroundImagePath);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    // 在工作线程解码，已显示时直接解码到键帽设备像素尺寸，完成后再安装
+    const QSize targetSize = isVisible() ? (QSizeF(size()) * devicePixelRatio()).toSize() : QSize();
+    m_backgroundRequest = BackgroundImageLoader::instance()->load(path, targetSize, this, [this](const QImage &image) {
+        m_backgroundRequest = 0;
+        if (!image.isNull()) {
+            m_backgroundPixmap = QPixmap::fromImage(image);
+            m_atlasPage.reset();
+            m_backgroundRect = QRect();
+            m_keyCapLayer.invalidate();
+            updateVisualState();
+            emit backgroundPixmapChanged(m_backgroundPixmap);
+        }
+        emit backgroundImageLoaded(!image.isNull());
+    });
+}
+
+void KeyButton::cancelBackgroundLoad() {
+    if (m_backgroundRequest == 0) {
+        return;
+    }
+    BackgroundImageLoader::instance()->cancel(m_backgroundRequest);
+    m_backgroundRequest = 0;
 }
 
 void KeyButton::setGlowLevel(qreal level) {
@@ -87,99 +173,62 @@ void KeyButton::setGlowLevel(qreal level) {
     emit glowLevelChanged(m_glowLevel);
 }
 
-void KeyButton::onFadeStep() {
-    const qreal step = 0.04;
-    // 每个周期衰减 glowLevel，直至停止计时器
-    if (m_glowLevel <= step) {
-        m_glowLevel = 0.0;
-        m_glowTimer.stop();
-    } else {
-        m_glowLevel -= step;
+void KeyButton::setInstrumentation(KeyboardInstrumentation *instrumentation, int slot) {
+    m_instrumentation = instrumentation;
+    m_instrumentationSlot = slot;
+}
+
+void KeyButton::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::FontChange) {
+        m_keyCapLayer.invalidate();
     }
-    updateVisualState();
+    QPushButton::changeEvent(event);
 }
 
 void KeyButton::updateVisualState() {
-    // 仅更新边框、圆角与文字颜色，背景交由 paintEvent 绘制以便叠加图片
-    QColor glow = m_highlightColor;
-    glow.setAlphaF(qBound<qreal>(0.0, m_glowLevel, 1.0));
-
-    const QString style = QString(
-        "QPushButton {"
-        "  color: %1;"
-        "  border: 1px solid rgba(%2, %3, %4, 200);"
-        "  border-radius: 4px;"
-        "  padding: 6px 8px;"
-        "}"
-        "QPushButton:pressed {"
-        "  border-color: rgba(%5, %6, %7, 230);"
-        "}"
-    )
-                            .arg(m_textColor.name())
-                            .arg(glow.red())
-                            .arg(glow.green())
-                            .arg(glow.blue())
-                            .arg(qMin(255, glow.red() + 40))
-                            .arg(qMin(255, glow.green() + 40))
-                            .arg(qMin(255, glow.blue() + 40));
-
-    setStyleSheet(style);
+    // 边框、按下与文字颜色均在 paintEvent 中依据缓存状态直接绘制，这里只需请求重绘；
+    // 不再使用样式表，避免每次热度/渐隐变化都触发样式重新解析与 polish
+    if (m_instrumentation) {
+        m_instrumentation->countVisualUpdate();
+    }
     update();
 }
 
-QColor KeyButton::mixColor(const QColor &a, const QColor &b, qreal factor) const {
-    // 线性插值返回中间色
-    factor = qBound<qreal>(0.0, factor, 1.0);
-    return QColor(
-        static_cast<int>(a.red() + (b.red() - a.red()) * factor),
-        static_cast<int>(a.green() + (b.green() - a.green()) * factor),
-        static_cast<int>(a.blue() + (b.blue() - a.blue()) * factor)
-    );
-}
-
 void KeyButton::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
-
-    // 热力图基础颜色
-    const qreal heatFactor = qBound<qreal>(0.0, static_cast<qreal>(m_heat) / static_cast<qreal>(m_heatMax), 1.0);
-    QColor baseColor = mixColor(m_coldColor, m_hotColor, heatFactor);
-
-    // 高亮叠加
-    QColor overlayColor = m_highlightColor;
-    overlayColor.setAlphaF(qBound<qreal>(0.0, m_glowLevel, 1.0));
-    baseColor = mixColor(baseColor, overlayColor, overlayColor.alphaF());
+    const qint64 paintStart = m_instrumentation ? m_instrumentation->now() : 0;
+
+    // 静态层只在尺寸、像素比或文字变化后重建，渐隐与热度变化不再重新排版文字、缩放贴图；
+    // 缩放拖动中只有尺寸变化，沿用已排版的文字
+    const QRectF area(rect());
+    if (!m_keyCapLayer.matches(area, *this) || m_keyCapLayer.label != text()) {
+        if (m_atlasPage) {
+            KeyPainter::updateKeyCapLayer(m_keyCapLayer, *this, area, text(), font(), m_textColor, m_atlasPage,
+                                          m_backgroundRect);
+        } else {
+            KeyPainter::updateKeyCapLayer(m_keyCapLayer, *this, area, text(), font(), m_textColor,
+                                          m_backgroundPixmap);
+        }
+    }
 
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing, true);
 
-    // 圆角矩形区域
-    const qreal radius = 6.0;
-    QRectF outer = QRectF(rect()).adjusted(1.5, 1.5, -1.5, -1.5);
-    QPainterPath path;
-    path.addRoundedRect(outer, radius, radius);
-
-    // 若存在背景图则先绘制贴图，再叠加颜色以保留热图与高亮效果
-    if (!m_backgroundPixmap.isNull()) {
-        QPixmap scaled = m_backgroundPixmap.scaled(outer.size().toSize(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-        // 计算裁剪区域，使图片充满圆角区域
-        const int sx = static_cast<int>((scaled.width() - outer.width()) / 2);
-        const int sy = static_cast<int>((scaled.height() - outer.height()) / 2);
-        const int sw = static_cast<int>(outer.width());
-        const int sh = static_cast<int>(outer.height());
-        QRect sourceRect(sx, sy, sw, sh);
-        painter.setClipPath(path);
-        painter.drawPixmap(outer.topLeft(), scaled, sourceRect);
-        painter.fillPath(path, QColor(baseColor.red(), baseColor.green(), baseColor.blue(), 140));
-    } else {
-        painter.fillPath(path, baseColor);
-    }
-
-    // 绘制边框
-    painter.setPen(QPen(overlayColor.isValid() ? overlayColor : baseColor, 1.2));
-    painter.drawPath(path);
-
-    // 显示文本
-    painter.setPen(m_textColor);
-    painter.setFont(font());
-    painter.drawText(outer, Qt::AlignCenter, text());
+    KeyCapStyle style;
+    style.highlightColor = m_highlightColor;
+    style.textColor = m_textColor;
+
+    KeyCapState state;
+    state.heatColor = QColor::fromRgb(m_heatGradient.colorAt(m_heatIndex));
+    state.glowLevel = m_glowLevel;
+    state.pressed = isDown();
+
+    // 合成逻辑与批量渲染模式共用，保证视觉一致
+    KeyPainter::paintKey(painter, m_keyCapLayer, style, state);
+
+    if (m_instrumentation) {
+        const qint64 paintEnd = m_instrumentation->now();
+        m_instrumentation->recordStage(KeyboardInstrumentation::Stage::Paint, paintEnd - paintStart);
+        m_instrumentation->keyPainted(m_instrumentationSlot, paintEnd);
+    }
 }
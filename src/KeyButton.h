@@ -1,10 +1,17 @@
 #pragma once
 
+#include "HeatGradient.h"
+#include "KeyPainter.h"
+#include "KeyboardInstrumentation.h"
+
 #include <QPushButton>
-#include <QTimer>
 
 #include <QPixmap>
 
+#include <memory>
+
+class QPropertyAnimation;
+
 // 单个按键按钮，负责热力图着色、高亮渐隐等效果
 class KeyButton : public QPushButton {
     Q_OBJECT
@@ -14,13 +21,17 @@ class KeyButton : public QPushButton {
 public:
     // 构造函数，text 为显示文本
     explicit KeyButton(const QString &text = QString(), QWidget *parent = nullptr);
+    ~KeyButton() override;
 
-    // 触发一次高亮动画，可指定持续时间（当前渐隐步长为定值）
+    // 独立使用时触发一次高亮动画，glowLevel 在 durationMs 内线性衰减到 0；
+    // 放在 VirtualKeyboardWidget 中时由键盘统一的动画时钟调用 setGlowLevel 驱动
     void triggerGlow(int durationMs = 900);
-    // 设置该键的统计次数以及全局最大次数，用于计算热力图强度
-    void setHeat(int count, int maxCount);
+    // 设置该键的热度（计数或衰减值）以及全局最大值，用于计算热力图强度
+    void setHeat(qreal heat, qreal maxHeat);
     // 设置冷/热配色
     void setHeatColors(const QColor &cold, const QColor &hot);
+    // 使用共享的热力图配色查找表（VirtualKeyboardWidget 为全部键共用一张表）
+    void setHeatGradient(const HeatGradient &gradient);
     // 设置高亮颜色
     void setHighlightColor(const QColor &color);
     // 设置基础文本颜色（在混合色上保持可读性）
@@ -28,47 +39,68 @@ public:
     // 为按键设置背景图片（可用于热图纹理化展示）
     void setBackgroundPixmap(const QPixmap &pixmap);
     const QPixmap &backgroundPixmap() const { return m_backgroundPixmap; }
-    // 便于在 Qt Designer 直接指定图片路径
+    // 使用图集页面中的子区域作为背景：页面由多个键共享，绘制时直接取样，不复制贴图；
+    // 此时 backgroundPixmap() 为空
+    void setBackgroundRegion(std::shared_ptr<const QPixmap> atlasPage, const QRect &sourceRect);
+    QRect backgroundSourceRect() const { return m_backgroundRect; }
+    // 便于在 Qt Designer 直接指定图片路径；图片在工作线程异步解码，完成后发出 backgroundImageLoaded
     void setBackgroundImagePath(const QString &path);
     QString backgroundImagePath() const { return m_backgroundImagePath; }
 
     qreal glowLevel() const { return m_glowLevel; }
     void setGlowLevel(qreal level);
 
+    // 性能埋点：绘制耗时与重绘请求计入 instrumentation，slot 为所在键位下标；传入空指针关闭
+    void setInstrumentation(KeyboardInstrumentation *instrumentation, int slot);
+
 signals:
     void glowLevelChanged(qreal level);
     void backgroundPixmapChanged(const QPixmap &pixmap);
     void backgroundImagePathChanged(const QString &path);
-
-private slots:
-    void onFadeStep();
+    // 路径图片异步加载完成（success 为 false 表示解码失败）
+    void backgroundImageLoaded(bool success);
 
 private:
-    // 更新视觉效果（样式表）
+    // 请求按当前状态重绘（不再使用样式表）
     void updateVisualState();
-    // 自定义绘制，确保背景图片与热力图颜色叠加
+    // 取消尚未完成的路径图片加载
+    void cancelBackgroundLoad();
+    // 自定义绘制：静态层（形状、贴图、文字）按需重建，每帧只合成热力色、高亮与边框
     void paintEvent(QPaintEvent *event) override;
-    // 颜色线性插值
-    QColor mixColor(const QColor &a, const QColor &b, qreal factor) const;
+    // 字体变化时丢弃静态层
+    void changeEvent(QEvent *event) override;
 
-    // 渐隐计时器，周期性降低 glowLevel
-    QTimer m_glowTimer;
-    // 热力图冷色
+    // 独立使用时的渐隐动画（按需创建，共用 Qt 的统一动画定时器）
+    QPropertyAnimation *m_glowAnimation {nullptr};
+    // 热力图冷/热配色
     QColor m_coldColor {QColor(30, 35, 45)};
-    // 热力图热色
     QColor m_hotColor {QColor(102, 170, 255)};
+    // 热力图配色查找表
+    HeatGradient m_heatGradient {m_coldColor, m_hotColor};
     // 高亮颜色
     QColor m_highlightColor {QColor(255, 51, 102)};
     // 文本基础色
     QColor m_textColor {Qt::white};
     // 按键背景图
     QPixmap m_backgroundPixmap;
+    // 使用图集时的共享页面及背景所在子区域
+    std::shared_ptr<const QPixmap> m_atlasPage;
+    QRect m_backgroundRect;
     // 背景图路径（便于序列化）
     QString m_backgroundImagePath;
-    // 当前按键计数
-    int m_heat {0};
-    // 全局最大计数
-    int m_heatMax {1};
+    // 未完成的异步加载请求编号，0 表示无
+    quint64 m_backgroundRequest {0};
+    // 当前热度
+    qreal m_heat {0.0};
+    // 全局最大热度
+    qreal m_heatMax {1.0};
+    // 当前计数对应的查找表下标，只在计数、最大值或映射方式变化时重算
+    int m_heatIndex {0};
+    // 性能埋点（不归本控件所有，未开启时为空）及所在键位
+    KeyboardInstrumentation *m_instrumentation {nullptr};
+    int m_instrumentationSlot {-1};
     // 当前高亮强度（0~1）
     qreal m_glowLevel {0.0};
+    // 键帽静态层，尺寸、像素比与文字变化在绘制时检测，字体、文本色与贴图变化时主动标记重绘
+    KeyCapLayer m_keyCapLayer;
 };
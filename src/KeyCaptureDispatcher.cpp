@@ -0,0 +1,115 @@
+#include "KeyCaptureDispatcher.h"
+
+#include "KeyStatisticsModel.h"
+
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QPointer>
+#include <QWindow>
+
+#include <iterator>
+
+KeyCaptureDispatcher *KeyCaptureDispatcher::instance() {
+    // 随应用程序对象销毁，之后再次调用时重新创建
+    static QPointer<KeyCaptureDispatcher> dispatcher;
+    if (!dispatcher && QCoreApplication::instance()) {
+        dispatcher = new KeyCaptureDispatcher(QCoreApplication::instance());
+    }
+    return dispatcher;
+}
+
+KeyCaptureDispatcher::KeyCaptureDispatcher(QObject *parent)
+    : QObject(parent) {
+}
+
+void KeyCaptureDispatcher::setReceiver(KeyStatisticsModel *model, bool application,
+                                       const QVector<QWindow *> &windows) {
+    m_applicationReceivers.removeAll(model);
+    for (auto it = m_windowReceivers.begin(); it != m_windowReceivers.end();) {
+        it.value().removeAll(model);
+        it = it.value().isEmpty() ? m_windowReceivers.erase(it) : std::next(it);
+    }
+
+    if (application) {
+        m_applicationReceivers.append(model);
+    } else {
+        for (QWindow *window : windows) {
+            if (!window) {
+                continue;
+            }
+            if (!m_windowReceivers.contains(window)) {
+                connect(window, &QObject::destroyed, this, &KeyCaptureDispatcher::forgetWindow,
+                        Qt::UniqueConnection);
+            }
+            QVector<KeyStatisticsModel *> &receivers = m_windowReceivers[window];
+            if (!receivers.contains(model)) {
+                receivers.append(model);
+            }
+        }
+    }
+    updateFilters();
+}
+
+void KeyCaptureDispatcher::removeReceiver(KeyStatisticsModel *model) {
+    setReceiver(model, false, {});
+}
+
+bool KeyCaptureDispatcher::eventFilter(QObject *watched, QEvent *event) {
+    ++m_filteredEvents;
+    // KeyPress 与 KeyRelease 的枚举值相邻，非按键事件只经过一次无符号比较即放行；
+    // 按键只在送达窗口时处理，之后转发给焦点控件与逐级上传给父控件的同一事件不再重复计入
+    static_assert(QEvent::KeyRelease == QEvent::KeyPress + 1);
+    if (static_cast<unsigned>(event->type() - QEvent::KeyPress) > 1u || !watched->isWindowType()) {
+        return false;
+    }
+    auto *keyEvent = static_cast<QKeyEvent *>(event);
+    // 取副本：处理按键时视图可能改变订阅
+    const QVector<KeyStatisticsModel *> receivers = m_applicationReceivers;
+    for (KeyStatisticsModel *model : receivers) {
+        model->captureKeyEvent(keyEvent);
+    }
+    const auto it = m_windowReceivers.constFind(static_cast<QWindow *>(watched));
+    if (it != m_windowReceivers.cend()) {
+        const QVector<KeyStatisticsModel *> windowReceivers = it.value();
+        for (KeyStatisticsModel *model : windowReceivers) {
+            model->captureKeyEvent(keyEvent);
+        }
+    }
+    return false;
+}
+
+void KeyCaptureDispatcher::updateFilters() {
+    const bool application = !m_applicationReceivers.isEmpty();
+    if (application != m_applicationFilter) {
+        m_applicationFilter = application;
+        if (application) {
+            QCoreApplication::instance()->installEventFilter(this);
+        } else {
+            QCoreApplication::instance()->removeEventFilter(this);
+        }
+    }
+
+    // 全局过滤器已经能看到送达各窗口的按键，此时不再在窗口上重复安装
+    QVector<QWindow *> wanted;
+    if (!application) {
+        wanted = m_windowReceivers.keys();
+    }
+    for (QWindow *window : std::as_const(m_filteredWindows)) {
+        if (!wanted.contains(window)) {
+            window->removeEventFilter(this);
+        }
+    }
+    for (QWindow *window : std::as_const(wanted)) {
+        if (!m_filteredWindows.contains(window)) {
+            window->installEventFilter(this);
+        }
+    }
+    m_filteredWindows = wanted;
+}
+
+void KeyCaptureDispatcher::forgetWindow(QObject *window) {
+    // 对象已在析构中，只作为键使用
+    auto *key = static_cast<QWindow *>(window);
+    m_windowReceivers.remove(key);
+    m_filteredWindows.removeAll(key);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+class KeyStatisticsModel;
+class QWindow;
+
+// 进程内唯一的物理按键分发器，全部统计模型共用：应用程序级捕获只安装一个事件过滤器，
+// 只有窗口级订阅时只在订阅的 QWindow 上安装，其它窗口与子控件的事件不经过过滤器。
+// 每个物理 KeyPress/KeyRelease 只在送达窗口时分发一次，转发给焦点控件与逐级上传的同一事件不再重复计入
+class KeyCaptureDispatcher : public QObject {
+    Q_OBJECT
+public:
+    // 在 GUI 线程中使用；尚无 QCoreApplication 时返回空指针
+    static KeyCaptureDispatcher *instance();
+
+    // 替换 model 的订阅：application 为 true 时接收全部窗口的按键，否则只接收 windows 中的窗口
+    void setReceiver(KeyStatisticsModel *model, bool application, const QVector<QWindow *> &windows);
+    // 取消 model 的全部订阅
+    void removeReceiver(KeyStatisticsModel *model);
+
+    // 经过过滤器的事件总数（含立即放行的非按键事件），用于评估过滤开销
+    quint64 filteredEventCount() const { return m_filteredEvents; }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    explicit KeyCaptureDispatcher(QObject *parent);
+    // 按当前订阅安装或移除过滤器：有应用程序级订阅时只装一个全局过滤器（同时服务窗口级订阅），
+    // 否则只装在被订阅的窗口上
+    void updateFilters();
+    // 窗口销毁时丢弃其订阅
+    void forgetWindow(QObject *window);
+
+    QVector<KeyStatisticsModel *> m_applicationReceivers;
+    QHash<QWindow *, QVector<KeyStatisticsModel *>> m_windowReceivers;
+    // 当前已安装过滤器的窗口
+    QVector<QWindow *> m_filteredWindows;
+    bool m_applicationFilter {false};
+    quint64 m_filteredEvents {0};
+};
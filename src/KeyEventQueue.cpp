@@ -0,0 +1,113 @@
+#include "KeyEventQueue.h"
+
+#include <utility>
+
+namespace {
+// 向上取整为 2 的幂，便于用掩码取模
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+} // namespace
+
+KeyEventQueue::KeyEventQueue(int capacity) {
+    const std::size_t size = roundUpToPowerOfTwo(static_cast<std::size_t>(qMax(2, capacity)));
+    m_slots.reset(new Slot[size]);
+    m_mask = size - 1;
+    // 槽位序号初始化为自身下标，表示可写
+    for (std::size_t i = 0; i < size; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+KeyEventQueue::~KeyEventQueue() = default;
+
+bool KeyEventQueue::push(int qtKey) {
+    std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (;;) {
+        slot = &m_slots[pos & m_mask];
+        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            // 槽位可写，抢占写入位置
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 队列已满：丢弃并计数，生产者不等待
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->qtKey = qtKey;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+
+    // 仅在消费者重新就绪后的首个事件上唤醒，避免每个事件投递一次。
+    // 与 rearmNotifier 构成“先写后读”的双向握手，两侧都需要全序栅栏：否则写入与读取标志可能重排，
+    // 生产者读到旧的 false、消费者同时看到空队列，唤醒就会丢失
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_notifyArmed.load(std::memory_order_relaxed) && m_notifyArmed.exchange(false, std::memory_order_acq_rel)) {
+        if (m_notifier) {
+            m_notifier();
+        }
+    }
+    return true;
+}
+
+int KeyEventQueue::drain(int *out, int maxEvents) {
+    int count = 0;
+    std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    while (count < maxEvents) {
+        Slot *slot = &m_slots[pos & m_mask];
+        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (!m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                continue;
+            }
+            out[count++] = slot->qtKey;
+            // 释放槽位供下一圈写入
+            slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            ++pos;
+        } else if (diff < 0) {
+            // 队列已空
+            break;
+        } else {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+void KeyEventQueue::setNotifier(std::function<void()> notifier) {
+    m_notifier = std::move(notifier);
+}
+
+bool KeyEventQueue::rearmNotifier() {
+    m_notifyArmed.store(true, std::memory_order_release);
+    // 与 push 中的栅栏配对：标志写入先于下面对队列位置的读取全局可见
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // 重新就绪与生产者写入之间可能存在竞争：若此时已有数据，由消费者自己继续处理
+    if (sizeApprox() > 0 && m_notifyArmed.exchange(false, std::memory_order_acq_rel)) {
+        return true;
+    }
+    return false;
+}
+
+int KeyEventQueue::sizeApprox() const {
+    const std::size_t enqueue = m_enqueuePos.load(std::memory_order_acquire);
+    const std::size_t dequeue = m_dequeuePos.load(std::memory_order_acquire);
+    return enqueue > dequeue ? static_cast<int>(enqueue - dequeue) : 0;
+}
+
+bool KeyEventQueue::overloaded() const {
+    return sizeApprox() > capacity() / 4 * 3;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// 多生产者按键事件队列：固定容量的无锁环形缓冲区（每个槽位带序号），
+// 任意线程可以 push，GUI 线程批量 drain。生产者从不阻塞、不分配内存；
+// 队列满时丢弃事件并计数，由 overloaded() 向生产者提供背压信号。
+class KeyEventQueue {
+public:
+    // capacity 会向上取整为 2 的幂
+    explicit KeyEventQueue(int capacity = 8192);
+    ~KeyEventQueue();
+
+    KeyEventQueue(const KeyEventQueue &) = delete;
+    KeyEventQueue &operator=(const KeyEventQueue &) = delete;
+
+    // 任意线程调用：写入一个按键事件，队列满时返回 false 并累计丢弃数
+    bool push(int qtKey);
+
+    // 消费线程调用：最多取出 maxEvents 个事件写入 out，返回实际数量
+    int drain(int *out, int maxEvents);
+
+    // 设置唤醒回调：队列从“已被消费完”变为有数据时，在生产者线程回调一次（不是每个事件一次）
+    void setNotifier(std::function<void()> notifier);
+    // 消费者处理完一批后调用，重新允许唤醒；若期间又有数据写入则返回 true，需要继续 drain
+    bool rearmNotifier();
+
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+    // 当前大致的积压量（并发下仅供参考）
+    int sizeApprox() const;
+    // 积压超过高水位（容量的 3/4）时视为过载，生产者可据此降速
+    bool overloaded() const;
+
+    // 累计成功写入、被丢弃的事件数
+    quint64 pushedCount() const { return m_pushed.load(std::memory_order_relaxed); }
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence {0};
+        int qtKey {0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask {0};
+    // 生产者与消费者位置分处不同缓存行，避免伪共享
+    alignas(64) std::atomic<std::size_t> m_enqueuePos {0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos {0};
+    alignas(64) std::atomic<quint64> m_pushed {0};
+    std::atomic<quint64> m_dropped {0};
+    // 为 true 时下一次成功写入会触发唤醒回调
+    std::atomic<bool> m_notifyArmed {true};
+    std::function<void()> m_notifier;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <Qt>
+#include <QtGlobal>
+
+#include <array>
+#include <iterator>
+
+// 编译期键位布局表与 Qt::Key 到槽位的直接寻址映射。
+// 布局以 constexpr 数组描述，构造时不再逐行分配 QList；
+// 视图按当前布局把槽位映射到紧凑键下标（KeyIndexTable），热路径上一次区间判断加一次数组下标即可得到键下标
+namespace KeyLayoutTables {
+
+// 单个键位（label 为 UTF-8 字面量）
+struct KeyDef {
+    const char *label;
+    int qtKey;
+    int columnSpan {1};
+    int rowSpan {1};
+};
+
+// 一整排键
+struct RowDef {
+    const KeyDef *keys;
+    int count;
+};
+
+// 功能键行
+inline constexpr KeyDef TopRow[] = {
+    {"Esc", Qt::Key_Escape},
+    {"F1", Qt::Key_F1}, {"F2", Qt::Key_F2}, {"F3", Qt::Key_F3}, {"F4", Qt::Key_F4},
+    {"F5", Qt::Key_F5}, {"F6", Qt::Key_F6}, {"F7", Qt::Key_F7}, {"F8", Qt::Key_F8},
+    {"F9", Qt::Key_F9}, {"F10", Qt::Key_F10}, {"F11", Qt::Key_F11}, {"F12", Qt::Key_F12},
+    {"PrtSc", Qt::Key_Print}, {"ScrLk", Qt::Key_ScrollLock}, {"Pause", Qt::Key_Pause},
+    {"Insert", Qt::Key_Insert}, {"Delete", Qt::Key_Delete}
+};
+
+// 数字行
+inline constexpr KeyDef NumberRow[] = {
+    {"`", Qt::Key_QuoteLeft},
+    {"1", Qt::Key_1}, {"2", Qt::Key_2}, {"3", Qt::Key_3}, {"4", Qt::Key_4}, {"5", Qt::Key_5},
+    {"6", Qt::Key_6}, {"7", Qt::Key_7}, {"8", Qt::Key_8}, {"9", Qt::Key_9}, {"0", Qt::Key_0},
+    {"-", Qt::Key_Minus}, {"=", Qt::Key_Equal},
+    {"Backspace", Qt::Key_Backspace, 2}
+};
+
+// Q 行
+inline constexpr KeyDef QRow[] = {
+    {"Tab", Qt::Key_Tab, 2},
+    {"Q", Qt::Key_Q}, {"W", Qt::Key_W}, {"E", Qt::Key_E}, {"R", Qt::Key_R}, {"T", Qt::Key_T},
+    {"Y", Qt::Key_Y}, {"U", Qt::Key_U}, {"I", Qt::Key_I}, {"O", Qt::Key_O}, {"P", Qt::Key_P},
+    {"[", Qt::Key_BracketLeft}, {"]", Qt::Key_BracketRight}, {"\\", Qt::Key_Backslash, 2}
+};
+
+// A 行
+inline constexpr KeyDef ARow[] = {
+    {"Caps", Qt::Key_CapsLock, 2},
+    {"A", Qt::Key_A}, {"S", Qt::Key_S}, {"D", Qt::Key_D}, {"F", Qt::Key_F}, {"G", Qt::Key_G},
+    {"H", Qt::Key_H}, {"J", Qt::Key_J}, {"K", Qt::Key_K}, {"L", Qt::Key_L},
+    {";", Qt::Key_Semicolon}, {"'", Qt::Key_Apostrophe},
+    {"Enter", Qt::Key_Return, 3}
+};
+
+// Z 行
+inline constexpr KeyDef ZRow[] = {
+    {"Shift", Qt::Key_Shift, 3},
+    {"Z", Qt::Key_Z}, {"X", Qt::Key_X}, {"C", Qt::Key_C}, {"V", Qt::Key_V}, {"B", Qt::Key_B},
+    {"N", Qt::Key_N}, {"M", Qt::Key_M}, {",", Qt::Key_Comma}, {".", Qt::Key_Period}, {"/", Qt::Key_Slash},
+    {"Shift", Qt::Key_Shift, 3}
+};
+
+// 空格与方向键行
+inline constexpr KeyDef BottomRow[] = {
+    {"Ctrl", Qt::Key_Control, 2},
+    {"Win", Qt::Key_Meta},
+    {"Alt", Qt::Key_Alt},
+    {"Space", Qt::Key_Space, 6},
+    {"Alt", Qt::Key_Alt},
+    {"Win", Qt::Key_Meta},
+    {"Menu", Qt::Key_Menu},
+    {"Ctrl", Qt::Key_Control, 2},
+    {"←", Qt::Key_Left}, {"↑", Qt::Key_Up}, {"↓", Qt::Key_Down}, {"→", Qt::Key_Right}
+};
+
+// 默认布局，按行自上而下
+inline constexpr RowDef StandardRows[] = {
+    {TopRow, int(std::size(TopRow))},
+    {NumberRow, int(std::size(NumberRow))},
+    {QRow, int(std::size(QRow))},
+    {ARow, int(std::size(ARow))},
+    {ZRow, int(std::size(ZRow))},
+    {BottomRow, int(std::size(BottomRow))}
+};
+
+// 常用 Qt::Key 集中在两段区间（Latin-1 与 0x01000000 起的功能键），各映射到 256 个连续槽位
+constexpr int SlotCount = 0x200;
+
+// Qt::Key -> 槽位，不在两段区间内返回 -1
+constexpr int keySlot(int qtKey) {
+    if (qtKey >= 0 && qtKey < 0x100) {
+        return qtKey;
+    }
+    if (qtKey >= 0x01000000 && qtKey < 0x01000100) {
+        return 0x100 + (qtKey - 0x01000000);
+    }
+    return -1;
+}
+
+// 槽位 -> Qt::Key
+constexpr int keyForSlot(int slot) {
+    return slot < 0x100 ? slot : 0x01000000 + (slot - 0x100);
+}
+
+// 槽位 -> 紧凑键下标，-1 表示不在布局中。
+// 下标按键在布局中首次出现的顺序分配，同一 Qt::Key 的多个键位（左右 Shift 等）共用一个下标
+using KeyIndexTable = std::array<qint16, SlotCount>;
+
+// 布局中的键位总数
+constexpr int cellCount(const RowDef *rows, int rowCount) {
+    int count = 0;
+    for (int row = 0; row < rowCount; ++row) {
+        count += rows[row].count;
+    }
+    return count;
+}
+
+// 布局中的每个键都必须落在查找表可寻址的区间内
+constexpr bool allKeysAddressable(const RowDef *rows, int rowCount) {
+    for (int row = 0; row < rowCount; ++row) {
+        for (int i = 0; i < rows[row].count; ++i) {
+            if (keySlot(rows[row].keys[i].qtKey) < 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline constexpr int StandardCellCount = cellCount(StandardRows, int(std::size(StandardRows)));
+
+static_assert(allKeysAddressable(StandardRows, int(std::size(StandardRows))),
+              "默认布局中的键必须落在 keySlot 可寻址区间内");
+
+} // namespace KeyLayoutTables
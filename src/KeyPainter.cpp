@@ -0,0 +1,307 @@
+#include "KeyPainter.h"
+
+#include <QCache>
+#include <QHashFunctions>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+namespace {
+// 缩放贴图缓存键：源图 cacheKey + 源子区域（图集）+ 目标逻辑尺寸 + 设备像素比
+struct ScaledPixmapKey {
+    qint64 sourceKey {0};
+    QRect sourceRect;
+    QSize size;
+    qreal devicePixelRatio {1.0};
+
+    bool operator==(const ScaledPixmapKey &other) const {
+        return sourceKey == other.sourceKey && sourceRect == other.sourceRect && size == other.size
+               && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+    }
+};
+
+size_t qHash(const ScaledPixmapKey &key, size_t seed = 0) {
+    return qHashMulti(seed, key.sourceKey, key.sourceRect.x(), key.sourceRect.y(), key.sourceRect.width(),
+                      key.sourceRect.height(), key.size.width(), key.size.height(), qRound(key.devicePixelRatio * 100));
+}
+
+// 全部键共用的有界缓存，成本单位为 KB；相同贴图、相同尺寸的多个键只占一份
+QCache<ScaledPixmapKey, QPixmap> &scaledPixmapCache() {
+    static QCache<ScaledPixmapKey, QPixmap> cache(32 * 1024);
+    return cache;
+}
+
+// 按设备像素缩放并居中裁剪，使图片恰好充满目标区域；图集贴图先取出子区域。
+// QPixmap 与 QImage 共用同一套步骤，光栅后端下两者结果一致
+template <typename Image>
+Image cropScaled(const Image &source, const QRect &sourceRect, const QSize &deviceSize) {
+    const Image region = sourceRect.isValid() ? source.copy(sourceRect) : source;
+    const Image scaled = region.scaled(deviceSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    const QRect cropRect((scaled.width() - deviceSize.width()) / 2, (scaled.height() - deviceSize.height()) / 2,
+                         deviceSize.width(), deviceSize.height());
+    return scaled.copy(cropRect);
+}
+
+// 重新生成键帽静态层；drawBackground(painter, outer) 在已设置圆角裁剪的 painter 上画出背景贴图，
+// 传 nullptr 时背景不画进图层（图集贴图在合成时取样），文字层仍按有贴图裁剪
+template <typename DrawBackground>
+void updateLayerWith(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                     const QFont &font, const QColor &textColor, bool hasBackground,
+                     [[maybe_unused]] DrawBackground drawBackground) {
+    const int logicalDpi = device.logicalDpiY();
+    // 文字、字体或 DPI 变化时按目标设备的字体重新排版，仅尺寸变化时沿用
+    if (label != layer.label || font != layer.labelFont || logicalDpi != layer.logicalDpi) {
+        layer.staticLabel = QStaticText(label);
+        layer.staticLabel.setTextFormat(Qt::PlainText);
+        layer.staticLabel.setPerformanceHint(QStaticText::AggressiveCaching);
+        layer.staticLabel.prepare(QTransform(), QFont(font, &device));
+        layer.labelFont = font;
+    }
+    layer.rect = rect;
+    layer.label = label;
+    layer.devicePixelRatio = device.devicePixelRatio();
+    layer.logicalDpi = logicalDpi;
+    layer.textured = hasBackground;
+    layer.background = QImage();
+    layer.atlasPage.reset();
+    layer.atlasSource = QRectF();
+    layer.text = QImage();
+
+    // 圆角矩形区域
+    const qreal radius = 6.0;
+    layer.outer = rect.adjusted(1.5, 1.5, -1.5, -1.5);
+    layer.path = QPainterPath();
+    layer.path.addRoundedRect(layer.outer, radius, radius);
+
+    // 图层覆盖键帽区域对齐到设备像素后的范围，合成时不产生重采样
+    const qreal dpr = layer.devicePixelRatio;
+    const QRect deviceRect = QRectF(rect.topLeft() * dpr, rect.size() * dpr).toAlignedRect();
+    layer.origin = QPointF(deviceRect.topLeft()) / dpr;
+    if (deviceRect.isEmpty()) {
+        return;
+    }
+    // 文字按目标设备的逻辑 DPI 排版，点数字号与直接绘制时大小相同
+    const int dotsPerMeter = qRound(layer.logicalDpi / 0.0254);
+    const auto newImage = [&deviceRect, dpr, dotsPerMeter]() {
+        QImage image(deviceRect.size(), QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.setDotsPerMeterX(dotsPerMeter);
+        image.setDotsPerMeterY(dotsPerMeter);
+        image.fill(Qt::transparent);
+        return image;
+    };
+
+    // 背景贴图先按圆角裁剪
+    if constexpr (!std::is_same_v<DrawBackground, std::nullptr_t>) {
+        if (hasBackground) {
+            layer.background = newImage();
+            QPainter painter(&layer.background);
+            painter.setRenderHint(QPainter::Antialiasing, true);
+            painter.translate(-layer.origin);
+            painter.setClipPath(layer.path);
+            drawBackground(painter, layer.outer);
+        }
+    }
+    // 文字层透明底，有贴图时同样限制在圆角内
+    if (!label.isEmpty()) {
+        layer.text = newImage();
+        QPainter painter(&layer.text);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.translate(-layer.origin);
+        if (hasBackground) {
+            painter.setClipPath(layer.path);
+        }
+        painter.setFont(font);
+        painter.setPen(textColor);
+        // 已排版的文字只按新尺寸重新居中
+        const QSizeF textSize = layer.staticLabel.size();
+        const QPointF topLeft(layer.outer.center().x() - textSize.width() / 2.0,
+                              layer.outer.center().y() - textSize.height() / 2.0);
+        painter.drawStaticText(topLeft, layer.staticLabel);
+    }
+}
+} // namespace
+
+bool KeyCapLayer::matches(const QRectF &targetRect, const QPaintDevice &device) const {
+    return isValid() && rect == targetRect && qFuzzyCompare(devicePixelRatio, device.devicePixelRatio())
+           && logicalDpi == device.logicalDpiY();
+}
+
+namespace KeyPainter {
+
+QPixmap scaledBackground(const QPixmap &source, const QRect &sourceRect, const QSize &size, qreal devicePixelRatio) {
+    if (source.isNull() || size.isEmpty()) {
+        return QPixmap();
+    }
+    const ScaledPixmapKey key {source.cacheKey(), sourceRect, size, devicePixelRatio};
+    auto &cache = scaledPixmapCache();
+    if (const QPixmap *cached = cache.object(key)) {
+        return *cached;
+    }
+
+    const QSize deviceSize = (QSizeF(size) * devicePixelRatio).toSize();
+    auto *cropped = new QPixmap(cropScaled(source, sourceRect, deviceSize));
+    cropped->setDevicePixelRatio(devicePixelRatio);
+
+    const QPixmap result = *cropped;
+    const int cost = qMax(1, deviceSize.width() * deviceSize.height() * 4 / 1024);
+    cache.insert(key, cropped, cost);
+    return result;
+}
+
+QImage scaledBackgroundImage(const QImage &source, const QRect &sourceRect, const QSize &size, qreal devicePixelRatio) {
+    if (source.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    QImage cropped = cropScaled(source, sourceRect, (QSizeF(size) * devicePixelRatio).toSize());
+    cropped.setDevicePixelRatio(devicePixelRatio);
+    return cropped;
+}
+
+void setScaledBackgroundCacheLimit(int kilobytes) {
+    scaledPixmapCache().setMaxCost(qMax(0, kilobytes));
+}
+
+QColor mixColor(const QColor &a, const QColor &b, qreal factor) {
+    // 线性插值返回中间色
+    factor = qBound<qreal>(0.0, factor, 1.0);
+    return QColor(
+        static_cast<int>(a.red() + (b.red() - a.red()) * factor),
+        static_cast<int>(a.green() + (b.green() - a.green()) * factor),
+        static_cast<int>(a.blue() + (b.blue() - a.blue()) * factor)
+    );
+}
+
+qint64 scaledBackgroundCacheUsage() {
+    return static_cast<qint64>(scaledPixmapCache().totalCost()) * 1024;
+}
+
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor, const QPixmap &background,
+                       const QRect &backgroundRect) {
+    // 缩放裁剪结果走缓存，多个同尺寸键共用一份
+    updateLayerWith(layer, device, rect, label, font, textColor, !background.isNull(),
+                    [&](QPainter &painter, const QRectF &outer) {
+        const QPixmap scaled = scaledBackground(background, backgroundRect, outer.size().toSize(),
+                                                device.devicePixelRatio());
+        painter.drawPixmap(outer.topLeft(), scaled);
+    });
+}
+
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor, const QImage &background,
+                       const QRect &backgroundRect) {
+    updateLayerWith(layer, device, rect, label, font, textColor, !background.isNull(),
+                    [&](QPainter &painter, const QRectF &outer) {
+        const QImage scaled = scaledBackgroundImage(background, backgroundRect, outer.size().toSize(),
+                                                    device.devicePixelRatio());
+        painter.drawImage(outer.topLeft(), scaled);
+    });
+}
+
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor,
+                       const std::shared_ptr<const QPixmap> &atlasPage, const QRect &atlasRect) {
+    const bool hasBackground = atlasPage && !atlasPage->isNull() && atlasRect.isValid();
+    updateLayerWith(layer, device, rect, label, font, textColor, hasBackground, nullptr);
+    if (!hasBackground) {
+        return;
+    }
+    // 与 scaledBackground 相同的居中裁剪：取子区域中与圆角矩形等比例的最大居中部分，合成时再缩放
+    const QSizeF sourceSize = layer.outer.size().scaled(QSizeF(atlasRect.size()), Qt::KeepAspectRatio);
+    if (sourceSize.isEmpty()) {
+        layer.textured = false;
+        return;
+    }
+    layer.atlasPage = atlasPage;
+    layer.atlasSource = QRectF(atlasRect.x() + (atlasRect.width() - sourceSize.width()) / 2.0,
+                               atlasRect.y() + (atlasRect.height() - sourceSize.height()) / 2.0,
+                               sourceSize.width(), sourceSize.height());
+}
+
+void paintKey(QPainter &painter, const KeyCapLayer &layer, const KeyCapStyle &style, const KeyCapState &state) {
+    // 热力图基础颜色
+    QColor baseColor = state.heatColor;
+
+    // 高亮叠加
+    QColor overlayColor = style.highlightColor;
+    overlayColor.setAlphaF(qBound<qreal>(0.0, state.glowLevel, 1.0));
+    baseColor = mixColor(baseColor, overlayColor, overlayColor.alphaF());
+
+    // 批量模式下同一 painter 连续绘制多个键，裁剪区域需在本键结束后恢复
+    painter.save();
+
+    // 有贴图时先合成已裁剪的贴图，再以半透明热力色覆盖；边框与文字同样限制在圆角内。
+    // 图集贴图在圆角裁剪下直接从页面子区域取样
+    if (layer.textured) {
+        if (layer.atlasPage) {
+            painter.setClipPath(layer.path);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+            painter.drawPixmap(layer.outer, *layer.atlasPage, layer.atlasSource);
+        } else {
+            painter.drawImage(layer.origin, layer.background);
+            painter.setClipPath(layer.path);
+        }
+        painter.fillPath(layer.path, QColor(baseColor.red(), baseColor.green(), baseColor.blue(), 140));
+    } else {
+        painter.fillPath(layer.path, baseColor);
+    }
+
+    // 绘制边框，按下时提亮边框颜色
+    QColor borderColor = overlayColor.isValid() ? overlayColor : baseColor;
+    if (state.pressed) {
+        borderColor = QColor(qMin(255, borderColor.red() + 40),
+                             qMin(255, borderColor.green() + 40),
+                             qMin(255, borderColor.blue() + 40),
+                             230);
+    }
+    painter.setPen(QPen(borderColor, 1.2));
+    painter.drawPath(layer.path);
+
+    // 文字层最后合成，保持在热力色之上
+    if (!layer.text.isNull()) {
+        painter.drawImage(layer.origin, layer.text);
+    }
+
+    painter.restore();
+}
+
+void paintKey(QPainter &painter, const QRectF &rect, const QString &label, const QPixmap &background,
+              const KeyCapStyle &style, const KeyCapState &state, const QRect &backgroundRect) {
+    KeyCapLayer layer;
+    updateKeyCapLayer(layer, *painter.device(), rect, label, painter.font(), style.textColor, background,
+                      backgroundRect);
+    paintKey(painter, layer, style, state);
+}
+
+void paintKey(QPainter &painter, const QRectF &rect, const QString &label, const QImage &background,
+              const KeyCapStyle &style, const KeyCapState &state, const QRect &backgroundRect) {
+    KeyCapLayer layer;
+    updateKeyCapLayer(layer, *painter.device(), rect, label, painter.font(), style.textColor, background,
+                      backgroundRect);
+    paintKey(painter, layer, style, state);
+}
+
+QRectF gridCellRect(const QRect &area, qreal spacing, int rowCount, int columnCount,
+                    int row, int column, int rowSpan, int columnSpan) {
+    const qreal cellW = std::max<qreal>((area.width() - spacing * (columnCount - 1)) / columnCount, 1.0);
+    const qreal cellH = std::max<qreal>((area.height() - spacing * (rowCount - 1)) / rowCount, 1.0);
+    const qreal x = area.left() + column * (cellW + spacing);
+    const qreal y = area.top() + row * (cellH + spacing);
+    const qreal w = columnSpan * cellW + (columnSpan - 1) * spacing;
+    const qreal h = rowSpan * cellH + (rowSpan - 1) * spacing;
+    return QRectF(x, y, w, h);
+}
+
+int autoScalePixelSize(int height, int rowCount, const QMargins &margins, int spacing) {
+    rowCount = std::max(rowCount, 1);
+    const int availableH = std::max(height - (margins.top() + margins.bottom()) - spacing * (rowCount - 1), 1);
+    const int keyHeight = std::max(availableH / rowCount, 12);
+    return std::clamp(static_cast<int>(keyHeight * 0.45), 9, 28);
+}
+
+} // namespace KeyPainter
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QMargins>
+#include <QPainterPath>
+#include <QPixmap>
+#include <QRectF>
+#include <QSize>
+#include <QStaticText>
+#include <QString>
+
+#include <memory>
+
+class QPainter;
+class QPaintDevice;
+
+// 键帽配色，整块键盘共用
+struct KeyCapStyle {
+    QColor highlightColor {QColor(255, 51, 102)}; // 高亮颜色
+    QColor textColor {Qt::white};               // 文本基础色
+};
+
+// 单个键帽的动态状态
+struct KeyCapState {
+    QColor heatColor;       // 热力图底色（由 HeatGradient 查表得到）
+    qreal glowLevel {0.0};  // 高亮强度（0~1）
+    bool pressed {false};   // 是否处于按下状态（边框提亮）
+};
+
+// 键帽静态层：圆角路径、按圆角裁剪的背景贴图与透明底文字，按键帽区域、设备像素比与 DPI 预先绘制一次。
+// 热力色、高亮与边框每帧在其上合成；尺寸变化时原地更新，字体、文本色或贴图变化时由持有方丢弃重建。
+// 图集贴图不复制进图层，合成时直接从共享页面的子区域取样
+struct KeyCapLayer {
+    QRectF rect;                 // 生成时的键帽区域
+    QString label;               // 生成时的文字
+    qreal devicePixelRatio {0.0}; // 0 表示尚未生成
+    int logicalDpi {0};
+    QRectF outer;                // 扣除边距后的圆角矩形
+    QPainterPath path;           // 圆角路径
+    QPointF origin;              // 图层左上角（逻辑坐标，已对齐到设备像素）
+    bool textured {false};       // 是否带背景贴图
+    QImage background;           // 已裁剪的背景贴图（非图集贴图）
+    std::shared_ptr<const QPixmap> atlasPage; // 图集页面，非空时背景取自其中的 atlasSource
+    QRectF atlasSource;          // 页面中与圆角矩形等比例、居中的取样区域
+    QImage text;                 // 文字层
+    // 已排版的文字，只随文字、字体与 DPI 变化，缩放过程中尺寸变化时沿用
+    QStaticText staticLabel;
+    QFont labelFont;
+
+    bool isValid() const { return devicePixelRatio > 0.0; }
+    // 标记图层需要重绘并放开图集页面（重新打包后旧页面可及时释放），已排版的文字保留（字体或文字未变时继续沿用）
+    void invalidate() {
+        devicePixelRatio = 0.0;
+        atlasPage.reset();
+    }
+    // 仍可用于在 device 上绘制 targetRect 区域
+    bool matches(const QRectF &targetRect, const QPaintDevice &device) const;
+};
+
+// 键帽绘制函数，KeyButton、VirtualKeyboardWidget 的批量渲染模式与 HeatMapRenderer 共用，保证画面一致
+namespace KeyPainter {
+// 颜色线性插值
+QColor mixColor(const QColor &a, const QColor &b, qreal factor);
+// 返回按目标逻辑尺寸与设备像素比缩放、居中裁剪后的贴图；sourceRect 有效时只取源图中的该子区域。
+// 结果按 (源图 cacheKey, 子区域, 尺寸, 像素比) 存入全部键共用的有界缓存，仅在尺寸或贴图变化时重新缩放
+QPixmap scaledBackground(const QPixmap &source, const QRect &sourceRect, const QSize &size, qreal devicePixelRatio);
+// 设置缩放贴图缓存上限（KB），默认 32 MB
+void setScaledBackgroundCacheLimit(int kilobytes);
+// 缩放贴图缓存当前占用（字节）
+qint64 scaledBackgroundCacheUsage();
+// 按 rect 重新生成键帽静态层，device 为最终绘制的目标设备（决定设备像素比与 DPI）；
+// 文字、字体与 DPI 均未变化时沿用 layer 中已排版的文字，只重绘图层
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor, const QPixmap &background,
+                       const QRect &backgroundRect = QRect());
+// 背景为 QImage 的版本，可在工作线程中调用
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor, const QImage &background,
+                       const QRect &backgroundRect = QRect());
+// 背景取自图集页面 atlasPage 中 atlasRect 子区域的版本：图层只记录页面与取样区域，不生成贴图副本，
+// 也不经过缩放贴图缓存
+void updateKeyCapLayer(KeyCapLayer &layer, const QPaintDevice &device, const QRectF &rect, const QString &label,
+                       const QFont &font, const QColor &textColor,
+                       const std::shared_ptr<const QPixmap> &atlasPage, const QRect &atlasRect);
+// 在静态层上合成热力色、高亮与边框，每帧只做这一步
+void paintKey(QPainter &painter, const KeyCapLayer &layer, const KeyCapStyle &style, const KeyCapState &state);
+// scaledBackground 的 QImage 版本：不经过缓存，可在任意线程调用，结果与 QPixmap 版本逐像素一致
+QImage scaledBackgroundImage(const QImage &source, const QRect &sourceRect, const QSize &size, qreal devicePixelRatio);
+// 在 rect 区域内绘制一个键帽（背景图、热力色、高亮边框与文字），字体由调用方提前设置；
+// backgroundRect 有效时背景取自 background 中的该子区域（图集页面）。每次调用都重新生成静态层，
+// 需要反复重绘的调用方应持有 KeyCapLayer 并用 updateKeyCapLayer 更新
+void paintKey(QPainter &painter, const QRectF &rect, const QString &label, const QPixmap &background,
+              const KeyCapStyle &style, const KeyCapState &state, const QRect &backgroundRect = QRect());
+// 背景为 QImage 的版本，不使用共享缓存，可在工作线程中向 QImage 绘制
+void paintKey(QPainter &painter, const QRectF &rect, const QString &label, const QImage &background,
+              const KeyCapStyle &style, const KeyCapState &state, const QRect &backgroundRect = QRect());
+
+// 键盘网格中一个键位的绘制区域：area 扣除间距后均分 rowCount×columnCount，与 QGridLayout 等比拉伸一致
+QRectF gridCellRect(const QRect &area, qreal spacing, int rowCount, int columnCount,
+                    int row, int column, int rowSpan, int columnSpan);
+// 自适应缩放的键帽字体像素大小：按行数估算单键高度后取一定比例
+int autoScalePixelSize(int height, int rowCount, const QMargins &margins, int spacing);
+} // namespace KeyPainter
@@ -0,0 +1,435 @@
+#include "KeyStatisticsModel.h"
+
+#include "KeyCaptureDispatcher.h"
+#include "KeyboardInstrumentation.h"
+
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QScreen>
+#include <QWidget>
+#include <QWindow>
+
+#include <algorithm>
+
+KeyStatisticsModel::KeyStatisticsModel(QObject *parent)
+    : QObject(parent) {
+    m_pendingSlot.fill(-1);
+
+    // 帧合并计时器，到期后一次性发出本帧累计的增量
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &KeyStatisticsModel::flush);
+
+    // 跨线程按键队列：队列由空转为有数据时投递一次取出任务，而不是每个事件一次
+    m_keyEventQueue = std::make_unique<KeyEventQueue>();
+    m_keyEventQueue->setNotifier([this]() {
+        QMetaObject::invokeMethod(this, &KeyStatisticsModel::drainKeyEventQueue, Qt::QueuedConnection);
+    });
+}
+
+KeyStatisticsModel::~KeyStatisticsModel() {
+    if (m_trackPhysicalKeyboard) {
+        if (KeyCaptureDispatcher *dispatcher = KeyCaptureDispatcher::instance()) {
+            dispatcher->removeReceiver(this);
+        }
+    }
+}
+
+void KeyStatisticsModel::setTrackPhysicalKeyboard(bool enabled) {
+    if (m_trackPhysicalKeyboard == enabled) {
+        return;
+    }
+    m_trackPhysicalKeyboard = enabled;
+    updateCapture();
+}
+
+void KeyStatisticsModel::setCaptureScope(CaptureScope scope) {
+    if (m_captureScope == scope) {
+        return;
+    }
+    m_captureScope = scope;
+    updateCapture();
+}
+
+void KeyStatisticsModel::setAutoRepeatPolicy(AutoRepeatPolicy policy) {
+    if (m_autoRepeatPolicy == policy) {
+        return;
+    }
+    m_autoRepeatPolicy = policy;
+    m_heldKeys.clear();
+}
+
+void KeyStatisticsModel::setKeyRateLimit(int eventsPerSecond) {
+    m_keyRateLimit = std::max(0, eventsPerSecond);
+    // 令牌桶按新上限从满桶开始
+    m_rateBuckets.fill(RateBucket());
+    m_otherRateBuckets.clear();
+}
+
+void KeyStatisticsModel::setTimingEnabled(bool enabled) {
+    m_timingEnabled = enabled;
+}
+
+void KeyStatisticsModel::addCaptureWidget(QWidget *widget) {
+    if (widget && !m_captureWidgets.contains(widget)) {
+        m_captureWidgets.append(widget);
+    }
+    // 已登记的控件再次调用时只刷新所在窗口
+    if (m_captureScope == CaptureScope::Window) {
+        updateCapture();
+    }
+}
+
+void KeyStatisticsModel::removeCaptureWidget(QWidget *widget) {
+    if (m_captureWidgets.removeAll(widget) > 0 && m_captureScope == CaptureScope::Window) {
+        updateCapture();
+    }
+}
+
+void KeyStatisticsModel::setFrameCoalescing(bool enabled) {
+    if (m_frameCoalescing == enabled) {
+        return;
+    }
+    m_frameCoalescing = enabled;
+    // 关闭合并时立即发出尚未发出的增量
+    if (!enabled) {
+        flush();
+    }
+}
+
+QHash<int, int> KeyStatisticsModel::counts() const {
+    QHash<int, int> result = m_otherCounts;
+    for (int slot = 0; slot < KeyLayoutTables::SlotCount; ++slot) {
+        if (m_slotCounts[slot] != 0) {
+            result.insert(KeyLayoutTables::keyForSlot(slot), m_slotCounts[slot]);
+        }
+    }
+    return result;
+}
+
+void KeyStatisticsModel::recordKey(int qtKey) {
+    recordSequentialKey(qtKey);
+}
+
+void KeyStatisticsModel::recordKeys(QSpan<const int> keys) {
+    m_pending.sequence.reserve(m_pending.sequence.size() + keys.size());
+    for (int qtKey : keys) {
+        accumulate(qtKey, 1, true);
+    }
+    requestFlush();
+}
+
+void KeyStatisticsModel::recordKeyCounts(const QHash<int, int> &counts) {
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        accumulate(it.key(), it.value(), false);
+    }
+    requestFlush();
+}
+
+void KeyStatisticsModel::setCounts(const QHash<int, int> &counts) {
+    // 待发增量先送达（其中的按键序列仍有意义），再整体替换
+    flush();
+    m_slotCounts.fill(0);
+    m_otherCounts.clear();
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        if (it.value() <= 0) {
+            continue;
+        }
+        const int slot = KeyLayoutTables::keySlot(it.key());
+        if (slot >= 0) {
+            m_slotCounts[slot] = it.value();
+        } else {
+            m_otherCounts.insert(it.key(), it.value());
+        }
+    }
+    if (m_statisticsStore) {
+        m_statisticsStore->reset(counts);
+    }
+    emitReset(false);
+}
+
+void KeyStatisticsModel::clear() {
+    flush();
+    m_slotCounts.fill(0);
+    m_otherCounts.clear();
+    m_repeatCounts.clear();
+    m_keyTimings.clear();
+    if (m_statisticsStore) {
+        m_statisticsStore->reset({});
+    }
+    emitReset(true);
+}
+
+void KeyStatisticsModel::flush() {
+    m_frameTimer.stop();
+    // 视图处理本批时又记录的按键进入下一批，由外层循环继续发出
+    if (m_flushing) {
+        return;
+    }
+    m_flushing = true;
+    while (!m_pending.changes.isEmpty() || !m_pending.sequence.isEmpty() || !m_pending.dwellChanged.isEmpty()) {
+        // 两组缓冲交替使用并保留容量，逐键路径不再分配内存
+        std::swap(m_pending, m_delivering);
+        for (const KeyCountChange &change : std::as_const(m_delivering.changes)) {
+            const int slot = KeyLayoutTables::keySlot(change.qtKey);
+            if (slot >= 0) {
+                m_pendingSlot[slot] = -1;
+            }
+        }
+        m_pendingOther.clear();
+        emit batchReady(m_delivering);
+        m_delivering.changes.clear();
+        m_delivering.sequence.clear();
+        m_delivering.dwellChanged.clear();
+    }
+    m_flushing = false;
+}
+
+bool KeyStatisticsModel::openStatisticsStore(const QString &directory) {
+    closeStatisticsStore();
+    m_statisticsStore = std::make_unique<HeatStatisticsStore>();
+    connect(m_statisticsStore.get(), &HeatStatisticsStore::writeFailed,
+            this, &KeyStatisticsModel::statisticsStoreFailed);
+    QHash<int, int> stored;
+    if (!m_statisticsStore->open(directory, &stored)) {
+        return false;
+    }
+    flush();
+    // 打开前已记录的计数作为增量并入存储
+    const QHash<int, int> existing = counts();
+    for (auto it = existing.cbegin(); it != existing.cend(); ++it) {
+        m_statisticsStore->append(it.key(), it.value());
+        stored[it.key()] += it.value();
+    }
+    m_slotCounts.fill(0);
+    m_otherCounts.clear();
+    for (auto it = stored.cbegin(); it != stored.cend(); ++it) {
+        const int slot = KeyLayoutTables::keySlot(it.key());
+        if (slot >= 0) {
+            m_slotCounts[slot] = it.value();
+        } else {
+            m_otherCounts.insert(it.key(), it.value());
+        }
+    }
+    emitReset(false);
+    return true;
+}
+
+void KeyStatisticsModel::closeStatisticsStore() {
+    m_statisticsStore.reset();
+}
+
+void KeyStatisticsModel::captureKeyEvent(const QKeyEvent *event) {
+    const int qtKey = event->key();
+    // 按键时长只看真实的按下与松开，与自动重复策略无关
+    if (m_timingEnabled && !event->isAutoRepeat()) {
+        const qint64 now = KeyboardInstrumentation::now();
+        if (event->type() == QEvent::KeyPress) {
+            m_keyTimings.press(qtKey, now);
+        } else if (event->type() == QEvent::KeyRelease && m_keyTimings.release(qtKey, now)) {
+            if (!m_pending.dwellChanged.contains(qtKey)) {
+                m_pending.dwellChanged.append(qtKey);
+            }
+            requestFlush();
+        }
+    }
+    if (event->type() == QEvent::KeyRelease) {
+        // 自动重复产生的松开（部分平台成对发出）不结束按住
+        if (!event->isAutoRepeat() && m_autoRepeatPolicy == AutoRepeatPolicy::Hold) {
+            const HeldKey held = m_heldKeys.take(qtKey);
+            if (held.repeated) {
+                emit keyHeld(qtKey, KeyboardInstrumentation::now() - held.pressedNs);
+            }
+        }
+        return;
+    }
+    if (event->type() != QEvent::KeyPress) {
+        return;
+    }
+
+    if (event->isAutoRepeat()) {
+        switch (m_autoRepeatPolicy) {
+        case AutoRepeatPolicy::Count:
+            break;
+        case AutoRepeatPolicy::Ignore:
+            return;
+        case AutoRepeatPolicy::Separate:
+            ++m_repeatCounts[qtKey];
+            return;
+        case AutoRepeatPolicy::Hold:
+            // 首次按下已经计数，之后的重复只延长这次按住；
+            // 切换策略前就已按下的键以第一次重复作为按下
+            if (auto it = m_heldKeys.find(qtKey); it != m_heldKeys.end()) {
+                it->repeated = true;
+                return;
+            }
+            m_heldKeys.insert(qtKey, HeldKey {KeyboardInstrumentation::now(), true});
+            break;
+        }
+    } else if (m_autoRepeatPolicy == AutoRepeatPolicy::Hold) {
+        m_heldKeys.insert(qtKey, HeldKey {KeyboardInstrumentation::now(), false});
+    }
+
+    if (m_instrumentation) {
+        // 到达时刻随增量送到视图，该键绘制完成时得到输入到像素的延迟
+        m_inputTimestampNs = KeyboardInstrumentation::now();
+        m_instrumentation->countKeyPress();
+        recordSequentialKey(qtKey);
+        m_instrumentation->recordStage(KeyboardInstrumentation::Stage::EventFilter,
+                                       KeyboardInstrumentation::now() - m_inputTimestampNs);
+        m_inputTimestampNs = 0;
+    } else {
+        recordSequentialKey(qtKey);
+    }
+}
+
+void KeyStatisticsModel::drainKeyEventQueue() {
+    // 每次最多处理一个批次，剩余部分让出事件循环后继续，避免长时间占用 GUI 线程；
+    // 积压超过高水位时多处理几个批次，尽快为生产者腾出空间
+    constexpr int batchSize = 4096;
+    m_drainBuffer.resize(batchSize);
+    const int rounds = m_keyEventQueue->overloaded() ? 4 : 1;
+
+    int drained = 0;
+    for (int round = 0; round < rounds; ++round) {
+        drained = m_keyEventQueue->drain(m_drainBuffer.data(), batchSize);
+        for (int i = 0; i < drained; ++i) {
+            accumulate(m_drainBuffer.at(i), 1, true);
+        }
+        if (drained < batchSize) {
+            break;
+        }
+    }
+    requestFlush();
+
+    const quint64 dropped = m_keyEventQueue->droppedCount();
+    if (dropped != m_reportedDrops) {
+        m_reportedDrops = dropped;
+        emit keyEventsDropped(dropped);
+    }
+
+    // 批次已满说明仍有积压；重新就绪时发现新数据也需要继续处理
+    if (drained == batchSize || m_keyEventQueue->rearmNotifier()) {
+        QMetaObject::invokeMethod(this, &KeyStatisticsModel::drainKeyEventQueue, Qt::QueuedConnection);
+    }
+}
+
+void KeyStatisticsModel::recordSequentialKey(int qtKey) {
+    if (accumulate(qtKey, 1, true)) {
+        requestFlush();
+    } else {
+        // 被限流的按键不单独发出，与同一帧内的其余按键合并为一批
+        scheduleFrameFlush();
+    }
+}
+
+bool KeyStatisticsModel::accumulate(int qtKey, int count, bool sequential) {
+    // 限流只影响发出节奏与按键序列，计数始终精确
+    bool admitted = true;
+    if (sequential) {
+        admitted = m_keyRateLimit <= 0 || admitKeyEvent(qtKey);
+        if (admitted) {
+            m_pending.sequence.append(qtKey);
+        }
+    }
+    if (count <= 0) {
+        return admitted;
+    }
+    // 常用键直接寻址，不经过哈希
+    const int slot = KeyLayoutTables::keySlot(qtKey);
+    int *position = nullptr;
+    if (slot >= 0) {
+        m_slotCounts[slot] += count;
+        position = &m_pendingSlot[slot];
+    } else {
+        m_otherCounts[qtKey] += count;
+        auto it = m_pendingOther.find(qtKey);
+        if (it == m_pendingOther.end()) {
+            it = m_pendingOther.insert(qtKey, -1);
+        }
+        position = &it.value();
+    }
+    // 同一键在一批内合并为一条增量
+    if (*position < 0) {
+        *position = m_pending.changes.size();
+        m_pending.changes.append({qtKey, 0, 0});
+    }
+    KeyCountChange &change = m_pending.changes[*position];
+    change.delta += count;
+    if (!admitted) {
+        change.throttled += count;
+    }
+    if (m_inputTimestampNs != 0 && change.inputNs == 0) {
+        change.inputNs = m_inputTimestampNs;
+    }
+    if (m_statisticsStore) {
+        m_statisticsStore->append(qtKey, count);
+    }
+    return admitted;
+}
+
+bool KeyStatisticsModel::admitKeyEvent(int qtKey) {
+    const int slot = KeyLayoutTables::keySlot(qtKey);
+    RateBucket &bucket = slot >= 0 ? m_rateBuckets[slot] : m_otherRateBuckets[qtKey];
+    const qint64 now = KeyboardInstrumentation::now();
+    const double capacity = m_keyRateLimit;
+    // 按经过的时间补充令牌，桶容量为一秒的上限
+    bucket.tokens = bucket.refillNs == 0
+                        ? capacity
+                        : std::min(capacity, bucket.tokens + (now - bucket.refillNs) * capacity / 1e9);
+    bucket.refillNs = now;
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        return true;
+    }
+    ++m_throttledEvents;
+    return false;
+}
+
+void KeyStatisticsModel::requestFlush() {
+    if (!m_frameCoalescing) {
+        flush();
+        return;
+    }
+    scheduleFrameFlush();
+}
+
+void KeyStatisticsModel::scheduleFrameFlush() {
+    // 每帧最多发出一批：首个增量启动单次计时器，同一帧内的后续事件只累计
+    if (!m_frameTimer.isActive()) {
+        const QScreen *screen = QGuiApplication::primaryScreen();
+        const qreal refreshRate = screen ? screen->refreshRate() : 60.0;
+        m_frameTimer.start(std::max(1, qRound(1000.0 / std::max<qreal>(refreshRate, 1.0))));
+    }
+}
+
+void KeyStatisticsModel::updateCapture() {
+    KeyCaptureDispatcher *dispatcher = KeyCaptureDispatcher::instance();
+    if (!dispatcher) {
+        return;
+    }
+    if (!m_trackPhysicalKeyboard) {
+        dispatcher->removeReceiver(this);
+        return;
+    }
+    // 窗口级：控件所在的顶层窗口（尚未显示的控件没有窗口，显示时由视图再次登记）
+    QVector<QWindow *> windows;
+    if (m_captureScope == CaptureScope::Window) {
+        m_captureWidgets.removeAll(nullptr);
+        for (const QPointer<QWidget> &widget : std::as_const(m_captureWidgets)) {
+            QWindow *window = widget->window()->windowHandle();
+            if (window && !windows.contains(window)) {
+                windows.append(window);
+            }
+        }
+    }
+    dispatcher->setReceiver(this, m_captureScope == CaptureScope::Application, windows);
+}
+
+void KeyStatisticsModel::emitReset(bool cleared) {
+    flush();
+    KeyStatisticsBatch batch;
+    batch.reset = true;
+    batch.cleared = cleared;
+    emit batchReady(batch);
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "HeatStatisticsStore.h"
+#include "KeyEventQueue.h"
+#include "KeyLayoutTables.h"
+#include "KeyTimingStatistics.h"
+
+#include <QHash>
+#include <QMetaType>
+#include <QObject>
+#include <QPointer>
+#include <QSpan>
+#include <QTimer>
+#include <QVector>
+
+#include <array>
+#include <memory>
+
+class KeyboardInstrumentation;
+class QKeyEvent;
+class QWidget;
+
+// 一个键在本批中的计数变化
+struct KeyCountChange {
+    int qtKey {0};
+    int delta {0};
+    qint64 inputNs {0}; // 本批中该键最早一次物理按下的时刻（KeyboardInstrumentation::now()），0 表示无
+    int throttled {0};  // 其中被限流合并的次数：已计入 delta，但不在按键序列中
+};
+
+// 模型发给视图的一批增量。计数被整体替换时 reset 为 true、不带增量，视图从模型重读全部计数
+struct KeyStatisticsBatch {
+    QVector<KeyCountChange> changes; // 每个键最多一条
+    QVector<int> sequence;           // 本批逐键按下的 Qt::Key（时间顺序），recordKeyCounts 注入的计数与被限流的按键不在其中
+    bool reset {false};              // 计数被 setCounts/clear/openStatisticsStore 整体替换
+    bool cleared {false};            // clear()：近期热度与转移等派生统计也应清空
+    QVector<int> dwellChanged;       // 本批中新增按住时长样本的 Qt::Key（开启 timingEnabled 时）
+};
+
+// 按键统计模型：事件只捕获一次、计数只存一份，多个 VirtualKeyboardWidget 视图共享。
+// 计数变化按批以 batchReady 发给视图，视图只重绘变化的键。
+// 常用键的计数按 KeyLayoutTables::keySlot 直接寻址存放，与视图的布局无关
+class KeyStatisticsModel : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool trackPhysicalKeyboard READ trackPhysicalKeyboard WRITE setTrackPhysicalKeyboard)
+    Q_PROPERTY(CaptureScope captureScope READ captureScope WRITE setCaptureScope)
+    Q_PROPERTY(AutoRepeatPolicy autoRepeatPolicy READ autoRepeatPolicy WRITE setAutoRepeatPolicy)
+    Q_PROPERTY(int keyRateLimit READ keyRateLimit WRITE setKeyRateLimit)
+    Q_PROPERTY(bool timingEnabled READ timingEnabled WRITE setTimingEnabled)
+    Q_PROPERTY(bool frameCoalescing READ frameCoalescing WRITE setFrameCoalescing)
+public:
+    // 物理按键的捕获范围
+    enum class CaptureScope {
+        Application, // 应用程序内全部窗口
+        Window       // 只捕获已登记控件所在的窗口，过滤器只装在这些窗口上
+    };
+    Q_ENUM(CaptureScope)
+
+    // 捕获到的自动重复 KeyPress 如何计入统计
+    enum class AutoRepeatPolicy {
+        Count,    // 与普通按下相同，逐次计数
+        Ignore,   // 丢弃
+        Separate, // 单独计数（repeatCount），不计入按键次数
+        Hold      // 整段按住只算一次按下，松开时发出 keyHeld 给出按住时长
+    };
+    Q_ENUM(AutoRepeatPolicy)
+
+    explicit KeyStatisticsModel(QObject *parent = nullptr);
+    ~KeyStatisticsModel() override;
+
+    bool trackPhysicalKeyboard() const { return m_trackPhysicalKeyboard; }
+    // 是否捕获物理按键；全部模型共用 KeyCaptureDispatcher 的同一个过滤器
+    void setTrackPhysicalKeyboard(bool enabled);
+
+    CaptureScope captureScope() const { return m_captureScope; }
+    void setCaptureScope(CaptureScope scope);
+    // 登记一个视图控件，窗口级捕获时监听它所在的窗口；控件显示或换到其它窗口后再次调用以更新
+    void addCaptureWidget(QWidget *widget);
+    void removeCaptureWidget(QWidget *widget);
+
+    // 处理一个捕获到的物理按键事件（KeyPress/KeyRelease），由 KeyCaptureDispatcher 调用，也可用于自行转发的事件
+    void captureKeyEvent(const QKeyEvent *event);
+
+    AutoRepeatPolicy autoRepeatPolicy() const { return m_autoRepeatPolicy; }
+    void setAutoRepeatPolicy(AutoRepeatPolicy policy);
+    // Separate 策略下某个键的自动重复次数
+    int repeatCount(int qtKey) const { return m_repeatCounts.value(qtKey, 0); }
+    QHash<int, int> repeatCounts() const { return m_repeatCounts; }
+
+    int keyRateLimit() const { return m_keyRateLimit; }
+    // 每个键每秒逐次处理的按键上限（令牌桶，允许一秒的突发），0 表示不限。
+    // 超出的按键照常计数，但不进入按键序列，并合并到下一帧的一批中发出，
+    // 卡键或脚本灌入时每帧的工作量有界
+    void setKeyRateLimit(int eventsPerSecond);
+    // 开启限流以来被合并的按键数
+    quint64 throttledEventCount() const { return m_throttledEvents; }
+
+    bool timingEnabled() const { return m_timingEnabled; }
+    // 是否按捕获到的 KeyPress/KeyRelease 统计每个键的按住时长与击键间隔（忽略自动重复），关闭时保留已有样本
+    void setTimingEnabled(bool enabled);
+    // 按键时长分布（clear() 时一并清空）
+    const KeyTimingStatistics &keyTimings() const { return m_keyTimings; }
+
+    bool frameCoalescing() const { return m_frameCoalescing; }
+    // 开启后增量在一个显示帧内合并，每帧最多发出一批；关闭时每次记录调用结束即发出
+    void setFrameCoalescing(bool enabled);
+
+    // 某个键的累计次数
+    int count(int qtKey) const {
+        const int slot = KeyLayoutTables::keySlot(qtKey);
+        return slot >= 0 ? m_slotCounts[slot] : m_otherCounts.value(qtKey, 0);
+    }
+    // 全部非零计数（Qt::Key -> 次数）
+    QHash<int, int> counts() const;
+
+    // 记录一次按键
+    void recordKey(int qtKey);
+    // 按顺序记录一组按键，合并为一批
+    void recordKeys(QSpan<const int> keys);
+    // 批量累加计数（不构成按键序列）
+    void recordKeyCounts(const QHash<int, int> &counts);
+    // 整体替换计数（同步到已打开的持久化存储）
+    void setCounts(const QHash<int, int> &counts);
+    // 清空全部统计
+    void clear();
+    // 立即发出尚未发出的增量
+    void flush();
+
+    // 线程安全的按键入口：任意线程可 push(Qt::Key)，在模型所在线程按批取出并记录。
+    // 队列归模型所有，生产者须在模型析构前停止写入
+    KeyEventQueue *keyEventQueue() const { return m_keyEventQueue.get(); }
+
+    // 打开统计持久化目录：读取快照与日志，打开前已记录的计数作为增量并入，失败时返回 false
+    bool openStatisticsStore(const QString &directory);
+    // 写出未落盘的增量并关闭持久化，计数保留在内存中
+    void closeStatisticsStore();
+    HeatStatisticsStore *statisticsStore() const { return m_statisticsStore.get(); }
+
+    // 物理按键埋点（由开启埋点的视图挂接，未挂接时只有一次空指针判断）：
+    // 捕获的 KeyPress 计入每秒次数与事件过滤耗时，并为增量标记到达时刻
+    KeyboardInstrumentation *instrumentation() const { return m_instrumentation; }
+    void setInstrumentation(KeyboardInstrumentation *instrumentation) { m_instrumentation = instrumentation; }
+
+signals:
+    // 一批计数变化
+    void batchReady(const KeyStatisticsBatch &batch);
+    // 跨线程队列出现丢弃，参数为累计丢弃数
+    void keyEventsDropped(quint64 totalDropped);
+    // 持久化存储写入失败（转发自 HeatStatisticsStore::writeFailed）；重置失败后存储已关闭
+    void statisticsStoreFailed(const QString &errorString);
+    // Hold 策略下一次按住（出现过自动重复）结束，durationNs 为按下到松开的时长
+    void keyHeld(int qtKey, qint64 durationNs);
+
+private slots:
+    // 在模型线程中批量取出跨线程队列中的按键事件
+    void drainKeyEventQueue();
+
+private:
+    // 累计计数并记入待发批次；sequential 表示按时间顺序的一次按键。
+    // 按键被限流时返回 false，此时只计数、不进入序列
+    bool accumulate(int qtKey, int count, bool sequential);
+    // 从该键的令牌桶取一个令牌，取不到时返回 false
+    bool admitKeyEvent(int qtKey);
+    // 非合并模式下立即发出，合并模式下安排到下一帧
+    void requestFlush();
+    // 安排在下一帧发出
+    void scheduleFrameFlush();
+    // 记录一次按键，被限流时推迟到下一帧发出
+    void recordSequentialKey(int qtKey);
+    // 先发出待发增量，再发出一个整体替换批次
+    void emitReset(bool cleared);
+    // 按开关、范围与已登记控件更新在分发器上的订阅
+    void updateCapture();
+
+    // 常用键直接寻址的计数与其余键的计数
+    std::array<int, KeyLayoutTables::SlotCount> m_slotCounts {};
+    QHash<int, int> m_otherCounts;
+    // 待发批次，以及每个键在 changes 中的位置（-1 表示本批尚未出现）
+    KeyStatisticsBatch m_pending;
+    KeyStatisticsBatch m_delivering; // 正在发出的批次
+    bool m_flushing {false};
+    std::array<int, KeyLayoutTables::SlotCount> m_pendingSlot;
+    QHash<int, int> m_pendingOther;
+    // 正在处理的物理 KeyPress 到达时刻（仅挂接埋点时）
+    qint64 m_inputTimestampNs {0};
+    KeyboardInstrumentation *m_instrumentation {nullptr};
+    bool m_trackPhysicalKeyboard {false};
+    CaptureScope m_captureScope {CaptureScope::Application};
+    // 窗口级捕获时监听其所在窗口的视图控件
+    QVector<QPointer<QWidget>> m_captureWidgets;
+    // 自动重复策略、单独计数的重复次数，以及 Hold 策略下正在按住的键
+    struct HeldKey {
+        qint64 pressedNs {0};
+        bool repeated {false};
+    };
+    AutoRepeatPolicy m_autoRepeatPolicy {AutoRepeatPolicy::Count};
+    QHash<int, int> m_repeatCounts;
+    QHash<int, HeldKey> m_heldKeys;
+    // 逐键限流：每个键一个令牌桶，常用键直接寻址
+    struct RateBucket {
+        qint64 refillNs {0}; // 上次补充令牌的时刻，0 表示尚未使用（桶是满的）
+        double tokens {0.0};
+    };
+    int m_keyRateLimit {0};
+    std::array<RateBucket, KeyLayoutTables::SlotCount> m_rateBuckets {};
+    QHash<int, RateBucket> m_otherRateBuckets;
+    quint64 m_throttledEvents {0};
+    // 按住时长与击键间隔
+    bool m_timingEnabled {false};
+    KeyTimingStatistics m_keyTimings;
+    bool m_frameCoalescing {false};
+    QTimer m_frameTimer;
+    // 跨线程按键事件队列及其取出缓冲
+    std::unique_ptr<KeyEventQueue> m_keyEventQueue;
+    QVector<int> m_drainBuffer;
+    // 已通过信号上报的丢弃数
+    quint64 m_reportedDrops {0};
+    // 计数持久化（未打开时不写盘）
+    std::unique_ptr<HeatStatisticsStore> m_statisticsStore;
+};
+
+Q_DECLARE_METATYPE(KeyStatisticsBatch)
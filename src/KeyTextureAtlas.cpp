@@ -0,0 +1,157 @@
+#include "KeyTextureAtlas.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <utility>
+
+KeyTextureAtlas::KeyTextureAtlas(const QSize &pageSize)
+    : m_pageSize(pageSize.expandedTo(QSize(64, 64))) {
+}
+
+void KeyTextureAtlas::insert(int id, const QImage &image) {
+    remove(id);
+    if (image.isNull()) {
+        return;
+    }
+
+    int pageIndex = -1;
+    QRect rect;
+    allocate(image.size(), &pageIndex, &rect);
+
+    // 直接覆盖写入目标区域（含透明像素）；页面只由共享指针引用，绘制不会复制页面
+    QPainter painter(m_pages[pageIndex].pixmap.get());
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(rect.topLeft(), image);
+    painter.end();
+
+    m_entries.insert(id, Entry {pageIndex, rect});
+    m_usedArea += static_cast<qint64>(rect.width()) * rect.height();
+}
+
+void KeyTextureAtlas::remove(int id) {
+    const auto it = m_entries.constFind(id);
+    if (it == m_entries.cend()) {
+        return;
+    }
+    const qint64 area = static_cast<qint64>(it->rect.width()) * it->rect.height();
+    m_entries.erase(it);
+    m_usedArea -= area;
+    m_wastedArea += area;
+
+    // 已放置区域不回收，其余贴图的子区域保持不变；空洞累计过多时整体重排
+    if (m_entries.isEmpty()) {
+        clear();
+    } else if (m_wastedArea > m_usedArea) {
+        compact();
+    }
+}
+
+void KeyTextureAtlas::clear() {
+    m_pages.clear();
+    m_entries.clear();
+    m_usedArea = 0;
+    m_wastedArea = 0;
+    ++m_generation;
+}
+
+std::shared_ptr<const QPixmap> KeyTextureAtlas::page(int id) const {
+    const auto it = m_entries.constFind(id);
+    return it == m_entries.cend() ? nullptr : m_pages.at(it->page).pixmap;
+}
+
+QRect KeyTextureAtlas::rect(int id) const {
+    return m_entries.value(id).rect;
+}
+
+QImage KeyTextureAtlas::image(int id) const {
+    const auto it = m_entries.constFind(id);
+    if (it == m_entries.cend()) {
+        return QImage();
+    }
+    return m_pages.at(it->page).pixmap->copy(it->rect).toImage();
+}
+
+void KeyTextureAtlas::compact() {
+    // 取出全部贴图后按高度从高到低重新装填，货架利用率更高
+    QList<std::pair<int, QImage>> images;
+    images.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        images.append({it.key(), m_pages.at(it->page).pixmap->copy(it->rect).toImage()});
+    }
+    std::sort(images.begin(), images.end(), [](const auto &a, const auto &b) {
+        return a.second.height() > b.second.height();
+    });
+
+    clear();
+    for (const auto &item : std::as_const(images)) {
+        insert(item.first, item.second);
+    }
+}
+
+qint64 KeyTextureAtlas::memoryUsage() const {
+    qint64 bytes = 0;
+    for (const Page &page : m_pages) {
+        bytes += static_cast<qint64>(page.pixmap->width()) * page.pixmap->height() * page.pixmap->depth() / 8;
+    }
+    return bytes;
+}
+
+void KeyTextureAtlas::allocate(const QSize &size, int *pageIndex, QRect *rect) {
+    // 超过页面尺寸的贴图单独占一页
+    if (size.width() > m_pageSize.width() || size.height() > m_pageSize.height()) {
+        *pageIndex = addPage(size);
+        Page &page = m_pages[*pageIndex];
+        page.shelves.append(Shelf {0, size.height(), size.width()});
+        *rect = QRect(QPoint(0, 0), size);
+        return;
+    }
+
+    for (int i = 0; i < m_pages.size(); ++i) {
+        if (allocateInPage(m_pages[i], size, rect)) {
+            *pageIndex = i;
+            return;
+        }
+    }
+    *pageIndex = addPage(m_pageSize);
+    allocateInPage(m_pages[*pageIndex], size, rect);
+}
+
+bool KeyTextureAtlas::allocateInPage(Page &page, const QSize &size, QRect *rect) {
+    const QSize pageSize = page.pixmap->size();
+
+    // 选择能放下且高度最贴近的货架
+    int best = -1;
+    for (int i = 0; i < page.shelves.size(); ++i) {
+        const Shelf &shelf = page.shelves.at(i);
+        if (shelf.height >= size.height() && pageSize.width() - shelf.x >= size.width()
+            && (best < 0 || shelf.height < page.shelves.at(best).height)) {
+            best = i;
+        }
+    }
+
+    // 没有合适货架或货架明显偏高时，尝试在底部新开一层
+    if (best < 0 || page.shelves.at(best).height > size.height() * 3 / 2) {
+        const int top = page.shelves.isEmpty() ? 0 : page.shelves.last().y + page.shelves.last().height;
+        if (top + size.height() <= pageSize.height()) {
+            page.shelves.append(Shelf {top, size.height(), 0});
+            best = page.shelves.size() - 1;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+
+    Shelf &shelf = page.shelves[best];
+    *rect = QRect(shelf.x, shelf.y, size.width(), size.height());
+    shelf.x += size.width();
+    return true;
+}
+
+int KeyTextureAtlas::addPage(const QSize &size) {
+    Page page;
+    page.pixmap = std::make_shared<QPixmap>(size);
+    page.pixmap->fill(Qt::transparent);
+    m_pages.append(page);
+    return m_pages.size() - 1;
+}
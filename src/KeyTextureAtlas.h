@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+#include <memory>
+
+// 键帽贴图图集：把各键（已缩小到显示尺寸）的贴图按“货架”方式打包进少量大页面，
+// 键帽绘制时直接从页面中的子区域取样，不再各自持有贴图副本。
+// 页面以共享指针交给各键，不产生 QPixmap 的隐式共享：新贴图原地写入页面空闲区域，不会复制整页，
+// 已放置的子区域保持不变；只有重新打包时子区域才会移动，此时 generation() 递增，调用方据此重新获取全部区域
+class KeyTextureAtlas {
+public:
+    explicit KeyTextureAtlas(const QSize &pageSize = QSize(1024, 1024));
+
+    // 放入一张贴图，同一 id 会替换旧贴图；超过页面尺寸的贴图单独占一页
+    void insert(int id, const QImage &image);
+    // 移除贴图；浪费空间超过一半时自动重新打包
+    void remove(int id);
+    void clear();
+
+    bool contains(int id) const { return m_entries.contains(id); }
+    QList<int> ids() const { return m_entries.keys(); }
+    // id 所在页面（共享，不要复制出 QPixmap 长期持有）与页面内的子区域，不存在时分别返回空指针与空矩形
+    std::shared_ptr<const QPixmap> page(int id) const;
+    QRect rect(int id) const;
+    // 取出 id 对应贴图的独立副本
+    QImage image(int id) const;
+
+    // 重新打包全部贴图，回收已移除贴图留下的空洞
+    void compact();
+    // 已有子区域被移动或页面被丢弃（重新打包、清空）的次数；不变时已取得的 page()/rect() 仍然有效
+    quint64 generation() const { return m_generation; }
+
+    int pageCount() const { return m_pages.size(); }
+    // 页面占用的总字节数
+    qint64 memoryUsage() const;
+    // 有效贴图像素占用的字节数
+    qint64 usedBytes() const { return m_usedArea * 4; }
+
+private:
+    // 一层货架：同一行从左到右依次摆放
+    struct Shelf {
+        int y {0};
+        int height {0};
+        int x {0};
+    };
+    struct Page {
+        std::shared_ptr<QPixmap> pixmap;
+        QList<Shelf> shelves;
+    };
+    struct Entry {
+        int page {0};
+        QRect rect;
+    };
+
+    // 为 size 分配位置，必要时新建页面
+    void allocate(const QSize &size, int *pageIndex, QRect *rect);
+    // 在指定页面中按货架分配位置
+    static bool allocateInPage(Page &page, const QSize &size, QRect *rect);
+    int addPage(const QSize &size);
+
+    QSize m_pageSize;
+    QVector<Page> m_pages;
+    QHash<int, Entry> m_entries;
+    // 有效贴图像素数与已移除贴图留下的空洞像素数
+    qint64 m_usedArea {0};
+    qint64 m_wastedArea {0};
+    quint64 m_generation {0};
+};
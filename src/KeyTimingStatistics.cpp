@@ -0,0 +1,111 @@
+#include "KeyTimingStatistics.h"
+
+KeyTimingStatistics::KeyTimingStatistics() {
+    m_slotIndex.fill(-1);
+}
+
+void KeyTimingStatistics::press(int qtKey, qint64 timestampNs) {
+    const int index = ensureIndex(qtKey);
+    KeyTiming &timing = *m_timings[index];
+
+    // 击键间隔计在本键上，连按同一个键（双字母）同样计入：上一个键仍按着（滚键、组合键）记 0，
+    // 停顿过久不计；同一个键仍按着说明漏掉了松开，没有可用的间隔
+    if (m_previousIndex >= 0) {
+        const KeyTiming &previous = *m_timings[m_previousIndex];
+        if (previous.pressedNs != 0) {
+            if (m_previousIndex != index && timestampNs - previous.pressedNs <= PauseThresholdNs) {
+                timing.flight.record(0);
+            }
+        } else if (previous.releasedNs != 0 && timestampNs - previous.releasedNs <= PauseThresholdNs) {
+            timing.flight.record(timestampNs - previous.releasedNs);
+        }
+    }
+    // 漏掉松开（如焦点切走）时以这次按下为准
+    timing.pressedNs = timestampNs;
+    m_previousIndex = index;
+}
+
+bool KeyTimingStatistics::release(int qtKey, qint64 timestampNs) {
+    const int index = indexOf(qtKey);
+    if (index < 0) {
+        return false;
+    }
+    KeyTiming &timing = *m_timings[index];
+    if (timing.pressedNs == 0) {
+        return false;
+    }
+    timing.dwell.record(timestampNs - timing.pressedNs);
+    timing.pressedNs = 0;
+    timing.releasedNs = timestampNs;
+    return true;
+}
+
+const KeyTimingStatistics::KeyTiming *KeyTimingStatistics::timing(int qtKey) const {
+    const int index = indexOf(qtKey);
+    return index >= 0 ? m_timings[index].get() : nullptr;
+}
+
+qint64 KeyTimingStatistics::dwellPercentile(int qtKey, double percentile) const {
+    const KeyTiming *found = timing(qtKey);
+    return found ? found->dwell.percentile(percentile) : 0;
+}
+
+qint64 KeyTimingStatistics::flightPercentile(int qtKey, double percentile) const {
+    const KeyTiming *found = timing(qtKey);
+    return found ? found->flight.percentile(percentile) : 0;
+}
+
+LogHistogram KeyTimingStatistics::dwellHistogram() const {
+    LogHistogram merged;
+    for (const auto &timing : m_timings) {
+        merged.merge(timing->dwell);
+    }
+    return merged;
+}
+
+LogHistogram KeyTimingStatistics::flightHistogram() const {
+    LogHistogram merged;
+    for (const auto &timing : m_timings) {
+        merged.merge(timing->flight);
+    }
+    return merged;
+}
+
+QVector<int> KeyTimingStatistics::keys() const {
+    QVector<int> result;
+    for (size_t i = 0; i < m_timings.size(); ++i) {
+        if (m_timings[i]->dwell.count() > 0 || m_timings[i]->flight.count() > 0) {
+            result.append(m_keys.at(static_cast<int>(i)));
+        }
+    }
+    return result;
+}
+
+void KeyTimingStatistics::clear() {
+    for (const auto &timing : m_timings) {
+        *timing = KeyTiming();
+    }
+    m_previousIndex = -1;
+}
+
+int KeyTimingStatistics::indexOf(int qtKey) const {
+    const int slot = KeyLayoutTables::keySlot(qtKey);
+    return slot >= 0 ? m_slotIndex[slot] : m_otherIndex.value(qtKey, -1);
+}
+
+int KeyTimingStatistics::ensureIndex(int qtKey) {
+    int index = indexOf(qtKey);
+    if (index >= 0) {
+        return index;
+    }
+    index = static_cast<int>(m_timings.size());
+    m_timings.push_back(std::make_unique<KeyTiming>());
+    m_keys.append(qtKey);
+    const int slot = KeyLayoutTables::keySlot(qtKey);
+    if (slot >= 0) {
+        m_slotIndex[slot] = index;
+    } else {
+        m_otherIndex.insert(qtKey, index);
+    }
+    return index;
+}
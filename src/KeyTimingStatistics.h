@@ -0,0 +1,62 @@
+#pragma once
+
+#include "KeyLayoutTables.h"
+#include "LogHistogram.h"
+
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// 每个键的按键时长分布：按住时长（dwell，按下到松开）与击键间隔（flight，上一个键松开到本键按下），
+// 各用一份 LogHistogram。每个键的直方图在首次按下时分配一次，之后记录只做 O(1) 的分桶自增，不分配内存
+class KeyTimingStatistics {
+public:
+    // 与上一次按键相隔超过此时长视为停顿，不计入击键间隔
+    static constexpr qint64 PauseThresholdNs = 2000000000;
+
+    struct KeyTiming {
+        LogHistogram dwell;    // 按住时长（纳秒）
+        LogHistogram flight;   // 击键间隔（纳秒），与上一个键重叠按下时记 0
+        qint64 pressedNs {0};  // 当前按下时刻，0 表示未按下
+        qint64 releasedNs {0}; // 最近一次松开时刻
+    };
+
+    KeyTimingStatistics();
+
+    // 按下与松开，时间戳为单调时钟纳秒（KeyboardInstrumentation::now()）；不应传入自动重复事件
+    void press(int qtKey, qint64 timestampNs);
+    // 得到一个按住时长样本时返回 true（未记录到对应按下的松开被忽略）
+    bool release(int qtKey, qint64 timestampNs);
+
+    // 某个键的分布，从未按下过时返回空指针
+    const KeyTiming *timing(int qtKey) const;
+    // 第 percentile（0~100）百分位（纳秒），没有样本时返回 0
+    qint64 dwellPercentile(int qtKey, double percentile) const;
+    qint64 flightPercentile(int qtKey, double percentile) const;
+    // 全部键合并后的分布
+    LogHistogram dwellHistogram() const;
+    LogHistogram flightHistogram() const;
+    // 有样本的键（Qt::Key）
+    QVector<int> keys() const;
+
+    // 清空样本，已分配的直方图保留复用
+    void clear();
+
+private:
+    // 键的存放下标，不存在时返回 -1
+    int indexOf(int qtKey) const;
+    int ensureIndex(int qtKey);
+
+    // 常用键按 KeyLayoutTables::keySlot 直接寻址，其余键查哈希
+    std::array<int, KeyLayoutTables::SlotCount> m_slotIndex;
+    QHash<int, int> m_otherIndex;
+    // 按首次按下顺序存放；逐个分配，扩容时不搬动直方图
+    std::vector<std::unique_ptr<KeyTiming>> m_timings;
+    QVector<int> m_keys;
+    // 上一次按下的键的下标
+    int m_previousIndex {-1};
+};
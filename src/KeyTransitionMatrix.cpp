@@ -0,0 +1,91 @@
+#include "KeyTransitionMatrix.h"
+
+#include <algorithm>
+#include <limits>
+
+void KeyTransitionMatrix::setKeys(const QVector<int> &qtKeys) {
+    m_keys = qtKeys;
+    m_index.clear();
+    m_index.reserve(m_keys.size());
+    for (int i = 0; i < m_keys.size(); ++i) {
+        m_index.insert(m_keys.at(i), i);
+    }
+    m_counts.fill(0, m_keys.size() * m_keys.size());
+    m_previous = -1;
+    m_total = 0;
+}
+
+void KeyTransitionMatrix::remapKeys(const QVector<int> &qtKeys) {
+    const QVector<int> oldKeys = m_keys;
+    const QVector<quint32> oldCounts = m_counts;
+    setKeys(qtKeys);
+
+    QVector<int> newIndex(oldKeys.size());
+    for (int i = 0; i < oldKeys.size(); ++i) {
+        newIndex[i] = indexOf(oldKeys.at(i));
+    }
+    const int keyCount = m_keys.size();
+    for (int from = 0; from < oldKeys.size(); ++from) {
+        if (newIndex.at(from) < 0) {
+            continue;
+        }
+        for (int to = 0; to < oldKeys.size(); ++to) {
+            const quint32 count = oldCounts.at(from * oldKeys.size() + to);
+            if (count != 0 && newIndex.at(to) >= 0) {
+                m_counts[newIndex.at(from) * keyCount + newIndex.at(to)] = count;
+                m_total += count;
+            }
+        }
+    }
+}
+
+void KeyTransitionMatrix::recordIndex(int index) {
+    if (index >= 0 && m_previous >= 0) {
+        quint32 &cell = m_counts[m_previous * m_keys.size() + index];
+        // 饱和计数，超大日志也不会回绕
+        if (cell != std::numeric_limits<quint32>::max()) {
+            ++cell;
+            ++m_total;
+        }
+    }
+    m_previous = index;
+}
+
+quint32 KeyTransitionMatrix::count(int fromKey, int toKey) const {
+    const int from = indexOf(fromKey);
+    const int to = indexOf(toKey);
+    return from < 0 || to < 0 ? 0 : countAt(from, to);
+}
+
+QVector<KeyTransitionMatrix::Transition> KeyTransitionMatrix::topTransitions(int n) const {
+    QVector<Transition> result;
+    if (n <= 0) {
+        return result;
+    }
+    // 只保留非零项再做部分排序，矩阵再稀疏也只扫一遍
+    QVector<int> cells;
+    for (int i = 0; i < m_counts.size(); ++i) {
+        if (m_counts.at(i) > 0) {
+            cells.append(i);
+        }
+    }
+    const auto byCount = [this](int a, int b) {
+        return m_counts.at(a) > m_counts.at(b) || (m_counts.at(a) == m_counts.at(b) && a < b);
+    };
+    const int taken = std::min<int>(n, cells.size());
+    std::partial_sort(cells.begin(), cells.begin() + taken, cells.end(), byCount);
+
+    result.reserve(taken);
+    const int size = m_keys.size();
+    for (int i = 0; i < taken; ++i) {
+        const int cell = cells.at(i);
+        result.append(Transition {m_keys.at(cell / size), m_keys.at(cell % size), m_counts.at(cell)});
+    }
+    return result;
+}
+
+void KeyTransitionMatrix::clear() {
+    m_counts.fill(0);
+    m_previous = -1;
+    m_total = 0;
+}
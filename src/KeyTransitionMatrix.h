@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+
+// 键到键的转移（二元组）统计：按紧凑键下标存放的稠密 K×K 计数矩阵，
+// 每次按键只做一次下标计算与自增
+class KeyTransitionMatrix {
+public:
+    // 一条转移及其次数
+    struct Transition {
+        int fromKey {0}; // Qt::Key
+        int toKey {0};   // Qt::Key
+        quint32 count {0};
+    };
+
+    // 设定参与统计的键（下标即在 qtKeys 中的位置），会清空已有统计
+    void setKeys(const QVector<int> &qtKeys);
+    // 更换键集合，起点与终点都仍在新集合中的转移保留原有次数
+    void remapKeys(const QVector<int> &qtKeys);
+    int keyCount() const { return m_keys.size(); }
+    // 紧凑下标与 Qt::Key 互查，不在统计范围内返回 -1
+    int indexOf(int qtKey) const { return m_index.value(qtKey, -1); }
+    int keyAt(int index) const { return m_keys.at(index); }
+
+    // 记录一次按键：与上一次按键构成一条转移
+    void record(int qtKey) { recordIndex(indexOf(qtKey)); }
+    // 按紧凑下标记录，调用方已知下标时免去查表；-1 会打断序列
+    void recordIndex(int index);
+    // 打断按键序列，下一次按键不与之前的按键相连（如会话切换）
+    void resetSequence() { m_previous = -1; }
+
+    quint32 count(int fromKey, int toKey) const;
+    quint32 countAt(int fromIndex, int toIndex) const { return m_counts.at(fromIndex * m_keys.size() + toIndex); }
+    // 累计转移总数
+    quint64 total() const { return m_total; }
+    // 次数最多的 n 条转移，按次数降序
+    QVector<Transition> topTransitions(int n) const;
+
+    // 清空计数（保留键集合）
+    void clear();
+
+private:
+    QVector<int> m_keys;
+    QHash<int, int> m_index;
+    QVector<quint32> m_counts; // 行为起点、列为终点
+    int m_previous {-1};
+    quint64 m_total {0};
+};
@@ -0,0 +1,111 @@
+#include "KeyboardInstrumentation.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+KeyboardInstrumentation::KeyboardInstrumentation(int slotCount)
+    : m_pendingInput(std::max(0, slotCount), 0) {
+    m_intervalStartNs = now();
+}
+
+qint64 KeyboardInstrumentation::now() {
+    static const QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed();
+}
+
+void KeyboardInstrumentation::setSlotCount(int slotCount) {
+    m_pendingInput.fill(0, std::max(0, slotCount));
+}
+
+void KeyboardInstrumentation::markInput(int slot, qint64 timestampNs) {
+    if (slot < 0 || slot >= m_pendingInput.size()) {
+        return;
+    }
+    // 同一键连续按下但尚未绘制时，按最早一次计算延迟
+    qint64 &pending = m_pendingInput[slot];
+    if (pending == 0) {
+        // 0 表示无等待输入，真实时间戳至少记为 1
+        pending = std::max<qint64>(1, timestampNs);
+    }
+}
+
+void KeyboardInstrumentation::keyPainted(int slot, qint64 paintedNs) {
+    if (slot < 0 || slot >= m_pendingInput.size()) {
+        return;
+    }
+    qint64 &pending = m_pendingInput[slot];
+    if (pending != 0) {
+        m_histograms[static_cast<int>(Stage::InputToPaint)].record(paintedNs - pending);
+        pending = 0;
+    }
+}
+
+void KeyboardInstrumentation::recordStage(Stage stage, qint64 durationNs) {
+    m_histograms[static_cast<int>(stage)].record(durationNs);
+    switch (stage) {
+    case Stage::Refresh:
+        ++m_refreshes;
+        break;
+    case Stage::Paint:
+        ++m_paints;
+        break;
+    default:
+        break;
+    }
+}
+
+InstrumentationReport KeyboardInstrumentation::report() const {
+    InstrumentationReport report;
+    report.intervalNs = now() - m_intervalStartNs;
+    const double seconds = std::max<qint64>(1, report.intervalNs) / 1e9;
+    report.keyPressesPerSecond = m_keyPresses / seconds;
+    report.refreshesPerSecond = m_refreshes / seconds;
+    report.paintsPerSecond = m_paints / seconds;
+    report.visualUpdatesPerSecond = m_visualUpdates / seconds;
+    report.filteredEventsPerSecond = m_filteredEvents / seconds;
+    report.inputToPaint = summarize(histogram(Stage::InputToPaint));
+    report.eventFilter = summarize(histogram(Stage::EventFilter));
+    report.refresh = summarize(histogram(Stage::Refresh));
+    report.paint = summarize(histogram(Stage::Paint));
+    return report;
+}
+
+InstrumentationReport KeyboardInstrumentation::takeReport() {
+    const InstrumentationReport current = report();
+    m_intervalStartNs += current.intervalNs;
+    m_keyPresses = 0;
+    m_refreshes = 0;
+    m_paints = 0;
+    m_visualUpdates = 0;
+    m_filteredEvents = 0;
+    return current;
+}
+
+void KeyboardInstrumentation::reset() {
+    for (LogHistogram &histogram : m_histograms) {
+        histogram.clear();
+    }
+    m_pendingInput.fill(0);
+    m_intervalStartNs = now();
+    m_keyPresses = 0;
+    m_refreshes = 0;
+    m_paints = 0;
+    m_visualUpdates = 0;
+    m_filteredEvents = 0;
+}
+
+LatencySummary KeyboardInstrumentation::summarize(const LogHistogram &histogram) {
+    LatencySummary summary;
+    summary.count = histogram.count();
+    summary.p50 = histogram.percentile(50.0);
+    summary.p90 = histogram.percentile(90.0);
+    summary.p99 = histogram.percentile(99.0);
+    summary.max = histogram.max();
+    summary.mean = histogram.mean();
+    return summary;
+}
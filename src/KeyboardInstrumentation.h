@@ -0,0 +1,85 @@
+#pragma once
+
+#include "LogHistogram.h"
+
+#include <QMetaType>
+#include <QVector>
+
+#include <array>
+
+// 单项耗时的摘要（纳秒）
+struct LatencySummary {
+    quint64 count {0};
+    qint64 p50 {0};
+    qint64 p90 {0};
+    qint64 p99 {0};
+    qint64 max {0};
+    double mean {0.0};
+};
+
+// 一次周期性上报：区间内的每秒次数与开启以来的耗时分布
+struct InstrumentationReport {
+    qint64 intervalNs {0};              // 本次上报覆盖的时长
+    double keyPressesPerSecond {0.0};   // eventFilter 收到的 KeyPress
+    double refreshesPerSecond {0.0};    // flushPendingUpdates 次数
+    double paintsPerSecond {0.0};       // 键盘批量绘制与 KeyButton 绘制次数
+    double visualUpdatesPerSecond {0.0}; // KeyButton 请求重绘的次数（原样式表更新路径）
+    double filteredEventsPerSecond {0.0}; // 经过按键捕获过滤器的全部事件（含立即放行的非按键事件），周期上报时汇总
+    LatencySummary inputToPaint;        // KeyPress 进入 eventFilter 到该键绘制完成
+    LatencySummary eventFilter;         // eventFilter 处理 KeyPress 的耗时
+    LatencySummary refresh;             // 一次 flushPendingUpdates 的耗时
+    LatencySummary paint;               // 一次 paintEvent 的耗时
+};
+
+// 键盘性能埋点：单调时钟纳秒时间戳、各阶段对数直方图与每秒计数。
+// 仅在 VirtualKeyboardWidget 开启 instrumentationEnabled 时创建，关闭时各埋点只是一次空指针判断
+class KeyboardInstrumentation {
+public:
+    enum class Stage {
+        InputToPaint,
+        EventFilter,
+        Refresh,
+        Paint
+    };
+
+    // slotCount 为可追踪的键位数（键位单元下标即槽位）
+    explicit KeyboardInstrumentation(int slotCount);
+    // 键位数变化（布局切换）时调整槽位，等待中的输入全部丢弃
+    void setSlotCount(int slotCount);
+
+    // 进程内共用的单调时钟当前时间（纳秒），模型与各视图的时间戳可直接相减
+    static qint64 now();
+
+    // KeyPress 到达，时间戳记在对应键位上，等待该键下一次绘制
+    void markInput(int slot, qint64 timestampNs);
+    // 键位绘制完成：若有等待中的输入则记录输入到像素的延迟
+    void keyPainted(int slot, qint64 paintedNs);
+    // 记录一次阶段耗时（EventFilter/Refresh/Paint 同时计入对应的每秒计数）
+    void recordStage(Stage stage, qint64 durationNs);
+    void countKeyPress() { ++m_keyPresses; }
+    void countVisualUpdate() { ++m_visualUpdates; }
+    void countFilteredEvents(quint64 count) { m_filteredEvents += count; }
+
+    const LogHistogram &histogram(Stage stage) const { return m_histograms[static_cast<int>(stage)]; }
+
+    // 自上次上报以来的报告（不重置计数区间）
+    InstrumentationReport report() const;
+    // 生成报告并开始新的计数区间
+    InstrumentationReport takeReport();
+    // 清空直方图、计数与等待中的输入
+    void reset();
+
+private:
+    static LatencySummary summarize(const LogHistogram &histogram);
+
+    std::array<LogHistogram, 4> m_histograms;
+    QVector<qint64> m_pendingInput; // 每个键位最早一次尚未绘制的输入时间，0 表示无
+    qint64 m_intervalStartNs {0};
+    quint64 m_keyPresses {0};
+    quint64 m_refreshes {0};
+    quint64 m_paints {0};
+    quint64 m_visualUpdates {0};
+    quint64 m_filteredEvents {0};
+};
+
+Q_DECLARE_METATYPE(InstrumentationReport)
@@ -0,0 +1,290 @@
+#include "KeyboardLayout.h"
+
+#include "KeyLayoutTables.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace {
+// 缓存格式：32 字节文件头 + 载荷（布局名、逐键定长字段与标签），多字节字段均为小端
+constexpr char CacheMagic[4] = {'E', 'K', 'L', 'Y'};
+constexpr quint16 CacheVersion = 1;
+constexpr int CacheHeaderSize = 32;
+constexpr int KeyFieldsSize = 12; // qtKey(4) row(2) column(2) columnSpan(1) rowSpan(1) labelSize(2)
+constexpr int MaxKeys = std::numeric_limits<qint16>::max();
+constexpr int MaxGrid = std::numeric_limits<quint16>::max();
+constexpr int MaxSpan = std::numeric_limits<quint8>::max();
+
+template <typename T>
+void appendLittleEndian(QByteArray &bytes, T value) {
+    uchar buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    bytes.append(reinterpret_cast<const char *>(buffer), sizeof(T));
+}
+
+void appendString(QByteArray &bytes, const QString &text) {
+    const QByteArray utf8 = text.toUtf8().left(std::numeric_limits<quint16>::max());
+    appendLittleEndian<quint16>(bytes, static_cast<quint16>(utf8.size()));
+    bytes.append(utf8);
+}
+
+// 解析 "A"、"Escape"、"Key_F1" 或数字形式的键码，无法识别时返回 0
+int parseKey(const QJsonValue &value) {
+    if (value.isDouble()) {
+        return value.toInt();
+    }
+    QString name = value.toString();
+    if (name.isEmpty()) {
+        return 0;
+    }
+    if (!name.startsWith(QLatin1String("Key_"))) {
+        name.prepend(QLatin1String("Key_"));
+    }
+    bool ok = false;
+    const int qtKey = QMetaEnum::fromType<Qt::Key>().keyToValue(name.toLatin1().constData(), &ok);
+    return ok ? qtKey : 0;
+}
+} // namespace
+
+KeyboardLayout KeyboardLayout::standard() {
+    KeyboardLayout layout;
+    layout.setName(QStringLiteral("ANSI"));
+    const auto &rows = KeyLayoutTables::StandardRows;
+    layout.m_keys.reserve(KeyLayoutTables::StandardCellCount);
+    for (int row = 0; row < static_cast<int>(std::size(rows)); ++row) {
+        int column = 0;
+        for (int i = 0; i < rows[row].count; ++i) {
+            const KeyLayoutTables::KeyDef &def = rows[row].keys[i];
+            layout.addKey({QString::fromUtf8(def.label), def.qtKey, row, column, def.columnSpan, def.rowSpan});
+            column += def.columnSpan;
+        }
+    }
+    return layout;
+}
+
+bool KeyboardLayout::load(const QString &path) {
+    if (!path.endsWith(QLatin1String(".json"), Qt::CaseInsensitive)) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            m_error = file.errorString();
+            return false;
+        }
+        return loadBinary(file.readAll());
+    }
+
+    const QFileInfo source(path);
+    const qint64 sourceSize = source.size();
+    const qint64 sourceModifiedMs = source.lastModified().toMSecsSinceEpoch();
+    const QString cachePath = cachePathFor(path);
+    if (loadCache(cachePath, sourceSize, sourceModifiedMs)) {
+        return true;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+    if (!loadJson(file.readAll())) {
+        return false;
+    }
+    // 缓存只是加速，写入失败（如只读目录）时照常使用解析结果
+    QSaveFile cache(cachePath);
+    if (cache.open(QIODevice::WriteOnly)) {
+        cache.write(toBinary(sourceSize, sourceModifiedMs));
+        cache.commit();
+    }
+    return true;
+}
+
+bool KeyboardLayout::loadCache(const QString &cachePath, qint64 sourceSize, qint64 sourceModifiedMs) {
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < CacheHeaderSize) {
+        return false;
+    }
+    const uchar *header = reinterpret_cast<const uchar *>(data.constData());
+    if (qFromLittleEndian<qint64>(header + 8) != sourceSize
+        || qFromLittleEndian<qint64>(header + 16) != sourceModifiedMs) {
+        return false;
+    }
+    return loadBinary(data);
+}
+
+bool KeyboardLayout::loadJson(const QByteArray &json) {
+    clear();
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        m_error = parseError.errorString();
+        return false;
+    }
+    const QJsonObject root = document.object();
+    const QJsonArray rows = root.value(QLatin1String("rows")).toArray();
+    if (rows.isEmpty()) {
+        m_error = QStringLiteral("layout has no rows");
+        return false;
+    }
+    m_name = root.value(QLatin1String("name")).toString();
+
+    // 每行从第 0 列起依次排放；gap 在键前留出空列，跨行键下方的位置需由下一行用 gap 让出
+    for (int row = 0; row < rows.size(); ++row) {
+        int column = 0;
+        const QJsonArray entries = rows.at(row).toArray();
+        for (const QJsonValue &entry : entries) {
+            // 字符串是 {"key": 名称} 的简写，标签即键名
+            const QJsonObject object = entry.isString()
+                ? QJsonObject {{QStringLiteral("key"), entry}}
+                : entry.toObject();
+            const QJsonValue keyValue = object.value(QLatin1String("key"));
+            Key key;
+            key.qtKey = parseKey(keyValue);
+            if (key.qtKey == 0) {
+                m_error = QStringLiteral("unknown key %1 in row %2")
+                              .arg(keyValue.isDouble() ? QString::number(keyValue.toInt()) : keyValue.toString())
+                              .arg(row);
+                clear();
+                return false;
+            }
+            key.label = object.value(QLatin1String("label")).toString(keyValue.toString());
+            column += std::max(0, object.value(QLatin1String("gap")).toInt(0));
+            key.row = row;
+            key.column = column;
+            key.columnSpan = object.value(QLatin1String("width")).toInt(1);
+            key.rowSpan = object.value(QLatin1String("height")).toInt(1);
+            addKey(key);
+            column += m_keys.last().columnSpan;
+        }
+    }
+    if (m_keys.size() > MaxKeys || m_rowCount > MaxGrid || m_columnCount > MaxGrid) {
+        m_error = QStringLiteral("layout is too large");
+        clear();
+        return false;
+    }
+    if (m_keys.isEmpty()) {
+        m_error = QStringLiteral("layout has no keys");
+        return false;
+    }
+    return true;
+}
+
+bool KeyboardLayout::loadBinary(const QByteArray &data) {
+    clear();
+    const uchar *header = reinterpret_cast<const uchar *>(data.constData());
+    if (data.size() < CacheHeaderSize || std::memcmp(header, CacheMagic, sizeof(CacheMagic)) != 0
+        || qFromLittleEndian<quint16>(header + 4) != CacheVersion) {
+        m_error = QStringLiteral("unsupported layout cache format");
+        return false;
+    }
+    const int keyCount = qFromLittleEndian<quint16>(header + 6);
+    const quint32 payloadSize = qFromLittleEndian<quint32>(header + 24);
+    const QByteArrayView payload(data.constData() + CacheHeaderSize, data.size() - CacheHeaderSize);
+    if (payload.size() != static_cast<qsizetype>(payloadSize)
+        || qChecksum(payload) != qFromLittleEndian<quint32>(header + 28)) {
+        m_error = QStringLiteral("layout cache is corrupted");
+        return false;
+    }
+
+    // 载荷已通过校验，这里只防御长度字段越界
+    const uchar *cursor = reinterpret_cast<const uchar *>(payload.data());
+    const uchar *end = cursor + payload.size();
+    const auto readString = [&cursor, end](QString *text) {
+        if (end - cursor < 2) {
+            return false;
+        }
+        const int size = qFromLittleEndian<quint16>(cursor);
+        cursor += 2;
+        if (end - cursor < size) {
+            return false;
+        }
+        *text = QString::fromUtf8(reinterpret_cast<const char *>(cursor), size);
+        cursor += size;
+        return true;
+    };
+
+    bool ok = readString(&m_name);
+    m_keys.reserve(keyCount);
+    for (int i = 0; ok && i < keyCount; ++i) {
+        if (end - cursor < KeyFieldsSize - 2) {
+            ok = false;
+            break;
+        }
+        Key key;
+        key.qtKey = qFromLittleEndian<qint32>(cursor);
+        key.row = qFromLittleEndian<quint16>(cursor + 4);
+        key.column = qFromLittleEndian<quint16>(cursor + 6);
+        key.columnSpan = cursor[8];
+        key.rowSpan = cursor[9];
+        cursor += KeyFieldsSize - 2;
+        ok = readString(&key.label);
+        addKey(key);
+    }
+    if (!ok || cursor != end || m_keys.isEmpty()) {
+        m_error = QStringLiteral("layout cache is corrupted");
+        clear();
+        return false;
+    }
+    return true;
+}
+
+QByteArray KeyboardLayout::toBinary(qint64 sourceSize, qint64 sourceModifiedMs) const {
+    QByteArray payload;
+    appendString(payload, m_name);
+    for (const Key &key : m_keys) {
+        appendLittleEndian<qint32>(payload, key.qtKey);
+        appendLittleEndian<quint16>(payload, static_cast<quint16>(std::clamp(key.row, 0, MaxGrid)));
+        appendLittleEndian<quint16>(payload, static_cast<quint16>(std::clamp(key.column, 0, MaxGrid)));
+        payload.append(static_cast<char>(std::clamp(key.columnSpan, 1, MaxSpan)));
+        payload.append(static_cast<char>(std::clamp(key.rowSpan, 1, MaxSpan)));
+        appendString(payload, key.label);
+    }
+
+    QByteArray data;
+    data.reserve(CacheHeaderSize + payload.size());
+    data.append(CacheMagic, sizeof(CacheMagic));
+    appendLittleEndian<quint16>(data, CacheVersion);
+    appendLittleEndian<quint16>(data, static_cast<quint16>(std::min<qsizetype>(m_keys.size(), MaxKeys)));
+    appendLittleEndian<qint64>(data, sourceSize);
+    appendLittleEndian<qint64>(data, sourceModifiedMs);
+    appendLittleEndian<quint32>(data, static_cast<quint32>(payload.size()));
+    appendLittleEndian<quint32>(data, qChecksum(payload));
+    data.append(payload);
+    return data;
+}
+
+QString KeyboardLayout::cachePathFor(const QString &jsonPath) {
+    return jsonPath + QStringLiteral(".bin");
+}
+
+void KeyboardLayout::addKey(const Key &key) {
+    Key normalized = key;
+    normalized.row = std::max(0, key.row);
+    normalized.column = std::max(0, key.column);
+    normalized.columnSpan = std::clamp(key.columnSpan, 1, MaxSpan);
+    normalized.rowSpan = std::clamp(key.rowSpan, 1, MaxSpan);
+    m_rowCount = std::max(m_rowCount, normalized.row + normalized.rowSpan);
+    m_columnCount = std::max(m_columnCount, normalized.column + normalized.columnSpan);
+    m_keys.append(normalized);
+}
+
+void KeyboardLayout::clear() {
+    m_name.clear();
+    m_keys.clear();
+    m_rowCount = 0;
+    m_columnCount = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// 运行期键盘布局：键位列表及其网格位置。
+// 布局源文件为 JSON，首次读取时编译为紧凑的二进制缓存（源文件同名加 .bin），
+// 之后只要源文件未改动就直接读取缓存，不再解析 JSON
+class KeyboardLayout {
+public:
+    // 单个键位
+    struct Key {
+        QString label;      // 键帽显示文本
+        int qtKey {0};      // 对应 Qt::Key
+        int row {0};        // 所在网格行
+        int column {0};     // 所在网格列
+        int columnSpan {1}; // 横向跨列数
+        int rowSpan {1};    // 纵向跨行数
+    };
+
+    // 内置默认布局（KeyLayoutTables::StandardRows）
+    static KeyboardLayout standard();
+
+    // 读取布局文件：.json 源文件优先使用未过期的二进制缓存，缓存缺失或过期时解析并重新生成缓存
+    // （缓存写入失败不影响读取）；其他扩展名按二进制缓存读取。失败时 errorString() 给出原因
+    bool load(const QString &path);
+    // 解析 JSON 源
+    bool loadJson(const QByteArray &json);
+    // 解析二进制缓存
+    bool loadBinary(const QByteArray &data);
+    // 编码为二进制缓存，sourceSize/sourceModifiedMs 记录源文件状态用于判断缓存是否过期
+    QByteArray toBinary(qint64 sourceSize = 0, qint64 sourceModifiedMs = 0) const;
+    // JSON 源文件对应的缓存路径
+    static QString cachePathFor(const QString &jsonPath);
+
+    QString name() const { return m_name; }
+    void setName(const QString &name) { m_name = name; }
+
+    // 追加一个键位，行列数随之扩展；跨度不足 1 时按 1 计
+    void addKey(const Key &key);
+    void clear();
+    const QVector<Key> &keys() const { return m_keys; }
+    bool isEmpty() const { return m_keys.isEmpty(); }
+    int rowCount() const { return m_rowCount; }
+    int columnCount() const { return m_columnCount; }
+
+    QString errorString() const { return m_error; }
+
+private:
+    // 读取缓存；源文件状态不符（已过期）时返回 false
+    bool loadCache(const QString &cachePath, qint64 sourceSize, qint64 sourceModifiedMs);
+
+    QString m_name;
+    QVector<Key> m_keys;
+    int m_rowCount {0};
+    int m_columnCount {0};
+    QString m_error;
+};
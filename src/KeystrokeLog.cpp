@@ -0,0 +1,92 @@
+#include "KeystrokeLog.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+KeystrokeLogWriter::~KeystrokeLogWriter() {
+    close();
+}
+
+bool KeystrokeLogWriter::open(const QString &path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    uchar header[KeystrokeLog::HeaderSize] = {};
+    std::memcpy(header, KeystrokeLog::Magic, sizeof(KeystrokeLog::Magic));
+    qToLittleEndian<quint16>(KeystrokeLog::Version, header + 4);
+    qToLittleEndian<quint16>(KeystrokeLog::RecordSize, header + 6);
+    return m_file.write(reinterpret_cast<const char *>(header), sizeof(header)) == sizeof(header);
+}
+
+void KeystrokeLogWriter::close() {
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool KeystrokeLogWriter::append(const KeystrokeLog::Record &record) {
+    uchar buffer[KeystrokeLog::RecordSize] = {};
+    qToLittleEndian<quint64>(record.timestampNs, buffer);
+    qToLittleEndian<qint32>(record.qtKey, buffer + 8);
+    buffer[12] = static_cast<uchar>(record.type);
+    return m_file.write(reinterpret_cast<const char *>(buffer), sizeof(buffer)) == sizeof(buffer);
+}
+
+KeystrokeLogReader::~KeystrokeLogReader() {
+    close();
+}
+
+bool KeystrokeLogReader::open(const QString &path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    const qint64 size = m_file.size();
+    if (size < KeystrokeLog::HeaderSize) {
+        m_error = QStringLiteral("keystroke log is truncated");
+        close();
+        return false;
+    }
+    // 整个文件只读映射，记录访问直接落在页缓存上
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        m_error = m_file.errorString();
+        close();
+        return false;
+    }
+    if (std::memcmp(m_data, KeystrokeLog::Magic, sizeof(KeystrokeLog::Magic)) != 0
+        || qFromLittleEndian<quint16>(m_data + 4) != KeystrokeLog::Version
+        || qFromLittleEndian<quint16>(m_data + 6) != KeystrokeLog::RecordSize) {
+        m_error = QStringLiteral("unsupported keystroke log format");
+        close();
+        return false;
+    }
+    // 末尾不完整的记录（录制中途中断）直接忽略
+    m_recordCount = (size - KeystrokeLog::HeaderSize) / KeystrokeLog::RecordSize;
+    m_error.clear();
+    return true;
+}
+
+void KeystrokeLogReader::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_recordCount = 0;
+}
+
+KeystrokeLog::Record KeystrokeLogReader::record(qint64 index) const {
+    KeystrokeLog::Record record;
+    record.timestampNs = timestampAt(index);
+    record.qtKey = keyAt(index);
+    record.type = typeAt(index);
+    return record;
+}
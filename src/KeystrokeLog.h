@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtEndian>
+#include <QtGlobal>
+
+// 二进制按键日志格式（小端）：
+//   文件头 16 字节：magic "EKBL" | quint16 版本 | quint16 记录长度 | 8 字节保留
+//   记录 16 字节：quint64 单调时钟时间戳（纳秒）| qint32 Qt::Key | quint8 事件类型 | 3 字节保留
+// 定长记录便于内存映射后按下标随机访问
+namespace KeystrokeLog {
+constexpr char Magic[4] = {'E', 'K', 'B', 'L'};
+constexpr quint16 Version = 1;
+constexpr int HeaderSize = 16;
+constexpr int RecordSize = 16;
+
+// 事件类型
+enum class EventType : quint8 {
+    Press = 0,
+    Release = 1,
+    AutoRepeat = 2
+};
+
+struct Record {
+    quint64 timestampNs {0};
+    int qtKey {0};
+    EventType type {EventType::Press};
+};
+} // namespace KeystrokeLog
+
+// 顺序写入按键日志（用于录制会话或生成测试数据）
+class KeystrokeLogWriter {
+public:
+    KeystrokeLogWriter() = default;
+    ~KeystrokeLogWriter();
+
+    // 创建（覆盖）日志文件并写入文件头
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // 追加一条记录（经 QFile 内部缓冲批量落盘）
+    bool append(const KeystrokeLog::Record &record);
+
+    QString errorString() const { return m_file.errorString(); }
+
+private:
+    QFile m_file;
+};
+
+// 以内存映射方式只读打开按键日志，记录按下标直接解码，不做整体拷贝
+class KeystrokeLogReader {
+public:
+    KeystrokeLogReader() = default;
+    ~KeystrokeLogReader();
+
+    KeystrokeLogReader(const KeystrokeLogReader &) = delete;
+    KeystrokeLogReader &operator=(const KeystrokeLogReader &) = delete;
+
+    // 映射日志文件并校验文件头，失败时 errorString() 给出原因
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    qint64 recordCount() const { return m_recordCount; }
+    // 解码第 index 条记录
+    KeystrokeLog::Record record(qint64 index) const;
+    // 只读取键值与类型，供聚合等热路径使用
+    int keyAt(qint64 index) const { return qFromLittleEndian<qint32>(recordData(index) + 8); }
+    KeystrokeLog::EventType typeAt(qint64 index) const { return static_cast<KeystrokeLog::EventType>(recordData(index)[12]); }
+    quint64 timestampAt(qint64 index) const { return qFromLittleEndian<quint64>(recordData(index)); }
+
+    QString errorString() const { return m_error; }
+
+private:
+    const uchar *recordData(qint64 index) const { return m_data + KeystrokeLog::HeaderSize + index * KeystrokeLog::RecordSize; }
+
+    QFile m_file;
+    const uchar *m_data {nullptr};
+    qint64 m_recordCount {0};
+    QString m_error;
+};
@@ -0,0 +1,198 @@
+#include "KeystrokeReplay.h"
+
+#include "KeyLayoutTables.h"
+#include "VirtualKeyboardWidget.h"
+
+#include <QScreen>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace {
+// 单帧最多处理的记录数，极高倍速时避免一帧卡住事件循环，剩余部分顺延到后续帧
+constexpr qint64 MaxRecordsPerFrame = 1 << 20;
+} // namespace
+
+KeystrokeReplay::KeystrokeReplay(QObject *parent)
+    : QObject(parent) {
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &KeystrokeReplay::onFrame);
+}
+
+bool KeystrokeReplay::open(const QString &path) {
+    stop();
+    return m_reader.open(path);
+}
+
+void KeystrokeReplay::close() {
+    stop();
+    m_reader.close();
+}
+
+KeystrokeReplay::Stats KeystrokeReplay::aggregate(QHash<int, int> *counts) const {
+    Stats stats;
+    if (!counts || !m_reader.isOpen()) {
+        return stats;
+    }
+    QElapsedTimer timer;
+    timer.start();
+
+    std::array<qint64, KeyLayoutTables::SlotCount> dense {};
+    QHash<int, qint64> sparse;
+    const qint64 total = m_reader.recordCount();
+    for (qint64 i = 0; i < total; ++i) {
+        // 松开事件不计入热力；自动重复与实时监听一致按按下计数
+        if (m_reader.typeAt(i) == KeystrokeLog::EventType::Release) {
+            continue;
+        }
+        const int qtKey = m_reader.keyAt(i);
+        const int slot = KeyLayoutTables::keySlot(qtKey);
+        if (slot >= 0) {
+            ++dense[slot];
+        } else {
+            ++sparse[qtKey];
+        }
+    }
+
+    const auto accumulate = [counts, &stats](int qtKey, qint64 count) {
+        const qint64 merged = counts->value(qtKey) + count;
+        counts->insert(qtKey, static_cast<int>(std::min<qint64>(merged, std::numeric_limits<int>::max())));
+        stats.keyPresses += count;
+    };
+    for (int slot = 0; slot < KeyLayoutTables::SlotCount; ++slot) {
+        if (dense[slot] > 0) {
+            accumulate(KeyLayoutTables::keyForSlot(slot), dense[slot]);
+        }
+    }
+    for (auto it = sparse.cbegin(); it != sparse.cend(); ++it) {
+        accumulate(it.key(), it.value());
+    }
+
+    stats.events = total;
+    stats.elapsedNs = timer.nsecsElapsed();
+    return stats;
+}
+
+KeystrokeReplay::Stats KeystrokeReplay::aggregateInto(VirtualKeyboardWidget *keyboard) const {
+    if (!keyboard) {
+        return Stats();
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QHash<int, int> counts;
+    Stats stats = aggregate(&counts);
+    keyboard->recordKeyCounts(counts);
+    stats.elapsedNs = timer.nsecsElapsed();
+    return stats;
+}
+
+void KeystrokeReplay::play(VirtualKeyboardWidget *keyboard, qreal speed) {
+    stop();
+    if (!keyboard || !m_reader.isOpen() || m_reader.recordCount() == 0) {
+        return;
+    }
+    m_keyboard = keyboard;
+    m_speed = std::max<qreal>(speed, 0.001);
+
+    // 按键盘所在屏幕的刷新率推进时间轴
+    const QScreen *currentScreen = keyboard->screen();
+    const qreal refreshRate = currentScreen ? currentScreen->refreshRate() : 60.0;
+    m_clock.start();
+    m_frameTimer.start(std::max(1, qRound(1000.0 / std::max<qreal>(refreshRate, 1.0))));
+}
+
+void KeystrokeReplay::pause() {
+    if (!isPlaying()) {
+        return;
+    }
+    foldElapsed();
+    m_frameTimer.stop();
+    m_clock.invalidate();
+}
+
+void KeystrokeReplay::resume() {
+    if (isPlaying() || !m_keyboard || m_position >= m_reader.recordCount()) {
+        return;
+    }
+    m_clock.start();
+    m_frameTimer.start();
+}
+
+void KeystrokeReplay::stop() {
+    m_frameTimer.stop();
+    m_clock.invalidate();
+    m_keyboard = nullptr;
+    m_position = 0;
+    m_logTimeNs = 0;
+    m_playElapsedNs = 0;
+    m_playKeyPresses = 0;
+    m_frameKeys.clear();
+}
+
+void KeystrokeReplay::setSpeed(qreal speed) {
+    speed = std::max<qreal>(speed, 0.001);
+    if (qFuzzyCompare(m_speed, speed)) {
+        return;
+    }
+    // 先按旧倍速结算已流逝的时间，新倍速只作用于之后
+    foldElapsed();
+    m_speed = speed;
+}
+
+KeystrokeReplay::Stats KeystrokeReplay::playbackStats() const {
+    Stats stats;
+    stats.events = m_position;
+    stats.keyPresses = m_playKeyPresses;
+    stats.elapsedNs = m_playElapsedNs + (m_clock.isValid() ? m_clock.nsecsElapsed() : 0);
+    return stats;
+}
+
+void KeystrokeReplay::onFrame() {
+    if (!m_keyboard) {
+        stop();
+        return;
+    }
+
+    const qint64 total = m_reader.recordCount();
+    const quint64 deadline = m_reader.timestampAt(0) + static_cast<quint64>(logTimeNs());
+    const qint64 frameEnd = std::min(total, m_position + MaxRecordsPerFrame);
+    while (m_position < frameEnd && m_reader.timestampAt(m_position) <= deadline) {
+        if (m_reader.typeAt(m_position) != KeystrokeLog::EventType::Release) {
+            m_frameKeys.append(m_reader.keyAt(m_position));
+        }
+        ++m_position;
+    }
+
+    // 本帧到期的按键一次性送入，键盘只累计计数并刷新一次
+    if (!m_frameKeys.isEmpty()) {
+        m_keyboard->recordKeys(m_frameKeys);
+        m_playKeyPresses += m_frameKeys.size();
+        m_frameKeys.clear();
+    }
+    emit progress(m_position, total);
+
+    if (m_position >= total) {
+        foldElapsed();
+        m_frameTimer.stop();
+        m_clock.invalidate();
+        emit finished(playbackStats());
+    }
+}
+
+void KeystrokeReplay::foldElapsed() {
+    if (!m_clock.isValid()) {
+        return;
+    }
+    const qint64 elapsed = m_clock.nsecsElapsed();
+    m_clock.start();
+    m_logTimeNs += static_cast<qint64>(elapsed * m_speed);
+    m_playElapsedNs += elapsed;
+}
+
+qint64 KeystrokeReplay::logTimeNs() const {
+    if (!m_clock.isValid()) {
+        return m_logTimeNs;
+    }
+    return m_logTimeNs + static_cast<qint64>(m_clock.nsecsElapsed() * m_speed);
+}
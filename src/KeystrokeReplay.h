@@ -0,0 +1,86 @@
+#pragma once
+
+#include "KeystrokeLog.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+class VirtualKeyboardWidget;
+
+// 按键日志回放：内存映射读取 KeystrokeLog 格式的录制文件，
+// 支持不渲染的快速聚合与按倍速驱动 VirtualKeyboardWidget 的实时回放
+class KeystrokeReplay : public QObject {
+    Q_OBJECT
+public:
+    // 一次聚合或回放的吞吐统计
+    struct Stats {
+        qint64 events {0};      // 处理的记录数（含松开事件）
+        qint64 keyPresses {0};  // 计入热力图的按下次数
+        qint64 elapsedNs {0};   // 实际耗时
+        double eventsPerSecond() const { return elapsedNs > 0 ? events * 1e9 / elapsedNs : 0.0; }
+    };
+
+    explicit KeystrokeReplay(QObject *parent = nullptr);
+
+    // 打开日志文件，会停止正在进行的回放
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_reader.isOpen(); }
+    QString errorString() const { return m_reader.errorString(); }
+    qint64 recordCount() const { return m_reader.recordCount(); }
+
+    // 聚合模式：一次扫描全部记录，把按下次数累加到 counts（Qt::Key -> 次数）
+    Stats aggregate(QHash<int, int> *counts) const;
+    // 聚合后一次性累加到键盘热力计数，整个日志只触发一次刷新
+    Stats aggregateInto(VirtualKeyboardWidget *keyboard) const;
+
+    // 回放模式：按录制时间轴乘以 speed 倍速把按键送入 keyboard，
+    // 每个显示帧到期的按键合并为一次 recordKeys，画面每帧最多刷新一次
+    void play(VirtualKeyboardWidget *keyboard, qreal speed = 1.0);
+    void pause();
+    void resume();
+    void stop();
+    bool isPlaying() const { return m_frameTimer.isActive(); }
+
+    qreal speed() const { return m_speed; }
+    // 回放中修改倍速从当前位置生效
+    void setSpeed(qreal speed);
+
+    // 已回放的记录数
+    qint64 position() const { return m_position; }
+    // 当前回放的累计吞吐
+    Stats playbackStats() const;
+
+signals:
+    // 每帧回放后报告进度
+    void progress(qint64 position, qint64 total);
+    // 回放到达日志末尾
+    void finished(const KeystrokeReplay::Stats &stats);
+
+private slots:
+    // 推进回放时间轴并送出到期的按键
+    void onFrame();
+
+private:
+    // 把已流逝的墙钟时间按当前倍速折算进日志时间轴
+    void foldElapsed();
+    // 当前回放位置对应的日志时间（相对首条记录）
+    qint64 logTimeNs() const;
+
+    KeystrokeLogReader m_reader;
+    QPointer<VirtualKeyboardWidget> m_keyboard;
+    QTimer m_frameTimer;
+    QElapsedTimer m_clock;
+    qreal m_speed {1.0};
+    qint64 m_position {0};
+    qint64 m_logTimeNs {0};       // 上次折算时的日志时间
+    qint64 m_playElapsedNs {0};   // 暂停前累计的墙钟耗时
+    qint64 m_playKeyPresses {0};
+    QVector<int> m_frameKeys;
+};
+
+Q_DECLARE_METATYPE(KeystrokeReplay::Stats)
@@ -0,0 +1,75 @@
+#include "LogHistogram.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void LogHistogram::record(qint64 value) {
+    value = std::max<qint64>(0, value);
+    ++m_buckets[bucketFor(value)];
+    m_min = m_count ? std::min(m_min, value) : value;
+    m_max = std::max(m_max, value);
+    m_sum += value;
+    ++m_count;
+}
+
+void LogHistogram::merge(const LogHistogram &other) {
+    if (other.m_count == 0) {
+        return;
+    }
+    for (int i = 0; i < BucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_min = m_count ? std::min(m_min, other.m_min) : other.m_min;
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+void LogHistogram::clear() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0;
+}
+
+qint64 LogHistogram::percentile(double percentile) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    const quint64 rank = std::max<quint64>(1, static_cast<quint64>(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * m_count)));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            // 桶上界不会超过实际最大值
+            return std::min(bucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+int LogHistogram::bucketFor(qint64 value) {
+    const quint64 v = static_cast<quint64>(std::max<qint64>(0, value));
+    if (v < SubBuckets) {
+        // 小值逐一精确计数
+        return static_cast<int>(v);
+    }
+    // 最高位决定所在的 2 的幂区间，其后 SubBucketBits 位决定区间内的细分
+    const int msb = 63 - static_cast<int>(qCountLeadingZeroBits(v));
+    const int shift = msb - SubBucketBits;
+    return ((shift + 1) << SubBucketBits) + static_cast<int>((v >> shift) & (SubBuckets - 1));
+}
+
+qint64 LogHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+    const int shift = (bucket >> SubBucketBits) - 1;
+    const quint64 lower = static_cast<quint64>((bucket & (SubBuckets - 1)) | SubBuckets) << shift;
+    const quint64 upper = lower + ((quint64(1) << shift) - 1);
+    return static_cast<qint64>(std::min<quint64>(upper, std::numeric_limits<qint64>::max()));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+// 对数分桶直方图（HDR 风格）：每个 2 的幂区间再均分 SubBuckets 份，
+// 相对误差不超过 1/SubBuckets。记录只做一次位运算与自增，不分配内存
+class LogHistogram {
+public:
+    static constexpr int SubBucketBits = 3;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int BucketCount = 64 << SubBucketBits;
+
+    // 记录一个非负样本（负值按 0 计）
+    void record(qint64 value);
+    // 合并另一份直方图
+    void merge(const LogHistogram &other);
+    void clear();
+
+    quint64 count() const { return m_count; }
+    qint64 min() const { return m_count ? m_min : 0; }
+    qint64 max() const { return m_max; }
+    double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+    // 第 percentile（0~100）百分位，返回所在桶的上界
+    qint64 percentile(double percentile) const;
+
+    // 样本值对应的桶下标及桶上界
+    static int bucketFor(qint64 value);
+    static qint64 bucketUpperBound(int bucket);
+
+private:
+    std::array<quint32, BucketCount> m_buckets {};
+    quint64 m_count {0};
+    qint64 m_min {0};
+    qint64 m_max {0};
+    qint64 m_sum {0};
+};
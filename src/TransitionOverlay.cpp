@@ -0,0 +1,68 @@
+#include "TransitionOverlay.h"
+
+#include <QLineF>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <cmath>
+
+TransitionOverlay::TransitionOverlay(QWidget *parent)
+    : QWidget(parent) {
+    // 纯装饰层：透明背景，点击穿透到下方键帽
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setFocusPolicy(Qt::NoFocus);
+}
+
+void TransitionOverlay::setArcs(const QVector<Arc> &arcs) {
+    m_arcs = arcs;
+    update();
+}
+
+void TransitionOverlay::setColor(const QColor &color) {
+    if (color == m_color) {
+        return;
+    }
+    m_color = color;
+    update();
+}
+
+void TransitionOverlay::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    if (m_arcs.isEmpty()) {
+        return;
+    }
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setBrush(Qt::NoBrush);
+
+    // 先画弱的再画强的，强转移不会被遮住
+    for (int i = m_arcs.size() - 1; i >= 0; --i) {
+        const Arc &arc = m_arcs.at(i);
+        QColor color = m_color;
+        color.setAlphaF(0.25 + 0.65 * arc.weight);
+        QPen pen(color, 1.0 + 5.0 * arc.weight, Qt::SolidLine, Qt::RoundCap);
+        painter.setPen(pen);
+
+        const QLineF line(arc.from, arc.to);
+        if (line.length() < 1.0) {
+            // 同一键连按：在键帽上方画一个小环
+            const qreal radius = 6.0 + 6.0 * arc.weight;
+            painter.drawEllipse(arc.from - QPointF(0, radius), radius, radius);
+            continue;
+        }
+
+        // 二次贝塞尔弧线，控制点沿法线方向偏移（始终偏向行进方向左侧，往返两条不重叠）
+        const QPointF middle = (arc.from + arc.to) / 2.0;
+        const QPointF normal(-line.dy() / line.length(), line.dx() / line.length());
+        const QPointF control = middle + normal * std::min<qreal>(line.length() * 0.3, 60.0);
+        QPainterPath path(arc.from);
+        path.quadTo(control, arc.to);
+        painter.drawPath(path);
+
+        // 终点处画一个圆点表示方向
+        painter.setBrush(color);
+        painter.drawEllipse(arc.to, pen.widthF() + 1.0, pen.widthF() + 1.0);
+        painter.setBrush(Qt::NoBrush);
+    }
+}
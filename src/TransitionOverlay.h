@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include <QWidget>
+
+// 键位转移叠加层：盖在键盘之上、不接收鼠标事件，按权重绘制转移弧线。
+// 只负责绘制，弧线端点与权重由 VirtualKeyboardWidget 计算后传入
+class TransitionOverlay : public QWidget {
+    Q_OBJECT
+public:
+    // 一条弧线：起止点（叠加层坐标）与 0~1 的权重
+    struct Arc {
+        QPointF from;
+        QPointF to;
+        qreal weight {0.0};
+    };
+
+    explicit TransitionOverlay(QWidget *parent = nullptr);
+
+    // 替换全部弧线并重绘
+    void setArcs(const QVector<Arc> &arcs);
+    void setColor(const QColor &color);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QVector<Arc> m_arcs;
+    QColor m_color {QColor(255, 65, 130)};
+};
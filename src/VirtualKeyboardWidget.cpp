@@ -1,83 +1,20 @@
 #include "VirtualKeyboardWidget.h"
 
-#include <QApplication>
-#include <QKeyEvent>
+#include "BackgroundImageLoader.h"
+#include "KeyCaptureDispatcher.h"
+#include "TransitionOverlay.h"
+
 #include <QLabel>
 #include <QLayout>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
 #include <QResizeEvent>
+#include <QScreen>
+#include <QShowEvent>
 
 #include <algorithm>
-
-namespace {
-// 生成功能键行
-QList<KeySpec> makeTopRow() {
-    return {
-        {"Esc", Qt::Key_Escape},
-        {"F1", Qt::Key_F1}, {"F2", Qt::Key_F2}, {"F3", Qt::Key_F3}, {"F4", Qt::Key_F4},
-        {"F5", Qt::Key_F5}, {"F6", Qt::Key_F6}, {"F7", Qt::Key_F7}, {"F8", Qt::Key_F8},
-        {"F9", Qt::Key_F9}, {"F10", Qt::Key_F10}, {"F11", Qt::Key_F11}, {"F12", Qt::Key_F12},
-        {"PrtSc", Qt::Key_Print}, {"ScrLk", Qt::Key_ScrollLock}, {"Pause", Qt::Key_Pause},
-        {"Insert", Qt::Key_Insert}, {"Delete", Qt::Key_Delete}
-    };
-}
-
-// 生成数字行
-QList<KeySpec> makeNumberRow() {
-    return {
-        {"`", Qt::Key_QuoteLeft},
-        {"1", Qt::Key_1}, {"2", Qt::Key_2}, {"3", Qt::Key_3}, {"4", Qt::Key_4}, {"5", Qt::Key_5},
-        {"6", Qt::Key_6}, {"7", Qt::Key_7}, {"8", Qt::Key_8}, {"9", Qt::Key_9}, {"0", Qt::Key_0},
-        {"-", Qt::Key_Minus}, {"=", Qt::Key_Equal},
-        {"Backspace", Qt::Key_Backspace, 2}
-    };
-}
-
-// 生成 Q 行
-QList<KeySpec> makeQRow() {
-    return {
-        {"Tab", Qt::Key_Tab, 2},
-        {"Q", Qt::Key_Q}, {"W", Qt::Key_W}, {"E", Qt::Key_E}, {"R", Qt::Key_R}, {"T", Qt::Key_T},
-        {"Y", Qt::Key_Y}, {"U", Qt::Key_U}, {"I", Qt::Key_I}, {"O", Qt::Key_O}, {"P", Qt::Key_P},
-        {"[", Qt::Key_BracketLeft}, {"]", Qt::Key_BracketRight}, {"\\", Qt::Key_Backslash, 2}
-    };
-}
-
-// 生成 A 行
-QList<KeySpec> makeARow() {
-    return {
-        {"Caps", Qt::Key_CapsLock, 2},
-        {"A", Qt::Key_A}, {"S", Qt::Key_S}, {"D", Qt::Key_D}, {"F", Qt::Key_F}, {"G", Qt::Key_G},
-        {"H", Qt::Key_H}, {"J", Qt::Key_J}, {"K", Qt::Key_K}, {"L", Qt::Key_L},
-        {";", Qt::Key_Semicolon}, {"'", Qt::Key_Apostrophe},
-        {"Enter", Qt::Key_Return, 3}
-    };
-}
-
-// 生成 Z 行
-QList<KeySpec> makeZRow() {
-    return {
-        {"Shift", Qt::Key_Shift, 3},
-        {"Z", Qt::Key_Z}, {"X", Qt::Key_X}, {"C", Qt::Key_C}, {"V", Qt::Key_V}, {"B", Qt::Key_B},
-        {"N", Qt::Key_N}, {"M", Qt::Key_M}, {",", Qt::Key_Comma}, {".", Qt::Key_Period}, {"/", Qt::Key_Slash},
-        {"Shift", Qt::Key_Shift, 3}
-    };
-}
-
-// 生成空格与方向键行
-QList<KeySpec> makeBottomRow() {
-    return {
-        {"Ctrl", Qt::Key_Control, 2},
-        {"Win", Qt::Key_Meta},
-        {"Alt", Qt::Key_Alt},
-        {"Space", Qt::Key_Space, 6},
-        {"Alt", Qt::Key_Alt},
-        {"Win", Qt::Key_Meta},
-        {"Menu", Qt::Key_Menu},
-        {"Ctrl", Qt::Key_Control, 2},
-        {"←", Qt::Key_Left}, {"↑", Qt::Key_Up}, {"↓", Qt::Key_Down}, {"→", Qt::Key_Right}
-    };
-}
-} // namespace
+#include <utility>
 
 VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
     : QWidget(parent) {
@@ -89,25 +26,39 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
     // 自适应缩放：行列均设置拉伸因子，保证放大缩小时布局比例一致
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
-    // 创建所有键位并添加到布局
-    QList<QList<KeySpec>> rows = {makeTopRow(), makeNumberRow(), makeQRow(), makeARow(), makeZRow(), makeBottomRow()};
+    // 自带统计模型，默认监听物理键盘；setStatisticsModel 可换成多个视图共享的模型
+    setStatisticsModel(nullptr);
 
-    int maxColumns = 0;
-    for (int row = 0; row < rows.size(); ++row) {
-        int column = 0;
-        for (const auto &spec : rows[row]) {
-            addKey(row, column, spec);
-            column += spec.columnSpan;
-        }
-        maxColumns = std::max(maxColumns, column);
-        // 行拉伸，保持纵向比例
-        m_layout->setRowStretch(row, 1);
-    }
+    // 默认布局来自编译期布局表，Widgets 模式下同时为每个键创建子控件
+    rebuildHeatGradient();
+    applyKeyboardLayout(KeyboardLayout::standard());
 
-    // 列拉伸，保持横向比例
-    for (int col = 0; col < maxColumns; ++col) {
-        m_layout->setColumnStretch(col, 1);
-    }
+    // 全部键共用一个动画时钟，按时间计算渐隐进度
+    m_glowTimer.setInterval(30);
+    connect(&m_glowTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::onGlowStep);
+    m_animationClock.start();
+
+    // 帧合并计时器，到期后一次性提交本帧累计的状态
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::flushPendingUpdates);
+
+    // 滑动窗口模式下按桶宽推进过期，窗口内无按键时停止
+    connect(&m_heatWindowTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::onHeatWindowStep);
+
+    // 转移叠加层最多每 100ms 重算一次最强转移
+    m_transitionOverlayTimer.setSingleShot(true);
+    m_transitionOverlayTimer.setInterval(100);
+    connect(&m_transitionOverlayTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::updateTransitionOverlay);
+
+    // 自适应缩放合并计时器，拖动缩放时每帧最多调整一次字体
+    m_autoScaleTimer.setSingleShot(true);
+    m_autoScaleTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_autoScaleTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::applyAutoScale);
+
+    // 埋点周期上报，仅在开启埋点时运行
+    m_instrumentationTimer.setInterval(1000);
+    connect(&m_instrumentationTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::reportInstrumentation);
 
     // 默认字体与大小
     setKeyFont(QFont("Inter", 10));
@@ -116,17 +67,20 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
 
     // 初次应用自适应策略，确保缩放时文字与画面比例保持稳定
     applyAutoScale();
-
-    // 需要监听硬件键盘时安装事件过滤器
-    if (m_trackPhysicalKeyboard) {
-        qApp->installEventFilter(this);
-    }
 }
 
 VirtualKeyboardWidget::~VirtualKeyboardWidget() {
-    // 析构时移除事件过滤器
-    if (m_trackPhysicalKeyboard) {
-        qApp->removeEventFilter(this);
+    // 先断开模型：自带模型随子对象析构时不再回调本控件，共享模型不再持有本控件的埋点
+    if (m_model) {
+        disconnect(m_model.data(), nullptr, this, nullptr);
+        m_model->removeCaptureWidget(this);
+        if (m_instrumentation && m_model->instrumentation() == m_instrumentation.get()) {
+            m_model->setInstrumentation(nullptr);
+        }
+    }
+    // 取消尚未完成的贴图解码
+    for (quint64 requestId : std::as_const(m_backgroundRequests)) {
+        BackgroundImageLoader::instance()->cancel(requestId);
     }
 }
 
@@ -135,16 +89,67 @@ QSize VirtualKeyboardWidget::sizeHint() const {
 }
 
 void VirtualKeyboardWidget::setTrackPhysicalKeyboard(bool enabled) {
-    if (m_trackPhysicalKeyboard == enabled) {
+    // 事件过滤器由模型安装，共享模型时整个进程只捕获一次
+    m_model->setTrackPhysicalKeyboard(enabled);
+}
+
+void VirtualKeyboardWidget::setCaptureScope(KeyStatisticsModel::CaptureScope scope) {
+    m_model->setCaptureScope(scope);
+}
+
+void VirtualKeyboardWidget::setAutoRepeatPolicy(KeyStatisticsModel::AutoRepeatPolicy policy) {
+    m_model->setAutoRepeatPolicy(policy);
+}
+
+void VirtualKeyboardWidget::setKeyRateLimit(int eventsPerSecond) {
+    m_model->setKeyRateLimit(eventsPerSecond);
+}
+
+void VirtualKeyboardWidget::setStatisticsModel(KeyStatisticsModel *model) {
+    if ((model && model == m_model) || (!model && m_ownsModel)) {
         return;
     }
-    m_trackPhysicalKeyboard = enabled;
-    // 根据开关安装/卸载事件过滤器
-    if (enabled) {
-        qApp->installEventFilter(this);
+    // 外部模型销毁时 QPointer 已置空，这里只处理仍然存活的旧模型
+    KeyStatisticsModel *previous = m_model;
+    const bool ownedPrevious = m_ownsModel;
+    if (previous) {
+        disconnect(previous, nullptr, this, nullptr);
+        previous->removeCaptureWidget(this);
+        if (m_instrumentation && previous->instrumentation() == m_instrumentation.get()) {
+            previous->setInstrumentation(nullptr);
+        }
+    }
+
+    m_ownsModel = (model == nullptr);
+    if (m_ownsModel) {
+        model = new KeyStatisticsModel(this);
+        model->setTrackPhysicalKeyboard(true);
     } else {
-        qApp->removeEventFilter(this);
+        connect(model, &QObject::destroyed, this, [this]() {
+            setStatisticsModel(nullptr);
+        });
+    }
+    m_model = model;
+    model->addCaptureWidget(this);
+    if (m_heatMode == HeatMode::MedianDwell) {
+        model->setTimingEnabled(true);
+    }
+    connect(model, &KeyStatisticsModel::batchReady, this, &VirtualKeyboardWidget::applyStatisticsBatch);
+    connect(model, &KeyStatisticsModel::keyEventsDropped, this, &VirtualKeyboardWidget::keyEventsDropped);
+    connect(model, &KeyStatisticsModel::statisticsStoreFailed, this, &VirtualKeyboardWidget::statisticsStoreFailed);
+    connect(model, &KeyStatisticsModel::keyHeld, this, &VirtualKeyboardWidget::keyHeld);
+    if (m_instrumentation && !model->instrumentation()) {
+        model->setInstrumentation(m_instrumentation.get());
     }
+    if (previous && ownedPrevious) {
+        delete previous;
+    }
+
+    // 按新模型的计数整盘重绘，近期热度与转移从头累计
+    KeyStatisticsBatch reset;
+    reset.reset = true;
+    reset.cleared = true;
+    applyStatisticsBatch(reset);
 }
 
 void VirtualKeyboardWidget::setHeatMapEnabled(bool enabled) {
@@ -154,22 +159,165 @@ void VirtualKeyboardWidget::setHeatMapEnabled(bool enabled) {
 
 void VirtualKeyboardWidget::setColdColor(const QColor &color) {
     m_coldColor = color;
+    rebuildHeatGradient();
     refreshHeatMap();
 }
 
 void VirtualKeyboardWidget::setHotColor(const QColor &color) {
     m_hotColor = color;
+    rebuildHeatGradient();
+    refreshHeatMap();
+}
+
+void VirtualKeyboardWidget::setHeatColorMap(HeatColorMap colorMap) {
+    if (m_heatColorMap == colorMap) {
+        return;
+    }
+    m_heatColorMap = colorMap;
+    rebuildHeatGradient();
+    refreshHeatMap();
+}
+
+void VirtualKeyboardWidget::setHeatColorStops(const QGradientStops &stops) {
+    m_heatColorStops = stops;
+    m_heatColorMap = HeatColorMap::Custom;
+    rebuildHeatGradient();
+    refreshHeatMap();
+}
+
+void VirtualKeyboardWidget::setHeatScale(HeatScale scale) {
+    if (m_heatScale == scale) {
+        return;
+    }
+    m_heatScale = scale;
+    rebuildHeatGradient();
+    refreshHeatMap();
+}
+
+void VirtualKeyboardWidget::setHeatMode(HeatMode mode) {
+    if (m_heatMode == mode) {
+        return;
+    }
+    m_heatMode = mode;
+    m_heatWindowTimer.stop();
+    m_heatActivity.setMode(mode == HeatMode::SlidingWindow ? HeatAccumulator::Mode::SlidingWindow
+                                                           : HeatAccumulator::Mode::Decay);
+    m_heatActivity.clear();
+    // 按住时长来自模型的按键时长统计，共享模型时对其它视图同样开启
+    if (mode == HeatMode::MedianDwell) {
+        m_model->setTimingEnabled(true);
+    }
     refreshHeatMap();
 }
 
+void VirtualKeyboardWidget::setHeatHalfLife(int halfLifeMs) {
+    m_heatActivity.setHalfLife(halfLifeMs);
+    if (m_heatMode == HeatMode::Decay) {
+        refreshHeatMap();
+    }
+}
+
+void VirtualKeyboardWidget::setHeatWindow(int windowMs) {
+    m_heatActivity.setWindow(windowMs);
+    if (m_heatMode == HeatMode::SlidingWindow) {
+        m_heatWindowTimer.stop();
+        refreshHeatMap();
+    }
+}
+
 void VirtualKeyboardWidget::setHighlightColor(const QColor &color) {
     m_highlightColor = color;
     // 同步到所有按钮
-    for (auto button : m_keyButtons) {
-        if (button) {
-            button->setHighlightColor(color);
+    for (const KeyCell &cell : std::as_const(m_keys)) {
+        if (cell.button) {
+            cell.button->setHighlightColor(color);
+        }
+    }
+    if (m_transitionOverlay) {
+        m_transitionOverlay->setColor(color);
+    }
+    if (m_renderMode == RenderMode::Batched) {
+        update();
+    }
+}
+
+void VirtualKeyboardWidget::setTransitionOverlay(bool enabled) {
+    if (m_transitionOverlayEnabled == enabled) {
+        return;
+    }
+    m_transitionOverlayEnabled = enabled;
+    if (!enabled) {
+        m_transitionOverlayTimer.stop();
+        delete m_transitionOverlay.data();
+        return;
+    }
+    // 叠加层作为最上层子控件覆盖整个键盘，两种渲染模式通用
+    m_transitionOverlay = new TransitionOverlay(this);
+    m_transitionOverlay->setColor(m_highlightColor);
+    m_transitionOverlay->setGeometry(rect());
+    m_transitionOverlay->raise();
+    m_transitionOverlay->show();
+    updateTransitionOverlay();
+}
+
+void VirtualKeyboardWidget::setInstrumentationEnabled(bool enabled) {
+    if (enabled == instrumentationEnabled()) {
+        return;
+    }
+    if (enabled) {
+        m_instrumentation = std::make_unique<KeyboardInstrumentation>(m_keys.size());
+        m_instrumentationTimer.start();
+        if (const KeyCaptureDispatcher *dispatcher = KeyCaptureDispatcher::instance()) {
+            m_filteredEventBaseline = dispatcher->filteredEventCount();
+        }
+        // 模型只挂接一份埋点；到达时刻取自进程共用时钟，其他开启埋点的视图同样能得到延迟
+        if (!m_model->instrumentation()) {
+            m_model->setInstrumentation(m_instrumentation.get());
+        }
+    } else {
+        m_instrumentationTimer.stop();
+        if (m_model->instrumentation() == m_instrumentation.get()) {
+            m_model->setInstrumentation(nullptr);
+        }
+    }
+    // 子控件持有的是裸指针，先同步再释放
+    for (int i = 0; i < m_keys.size(); ++i) {
+        if (m_keys.at(i).button) {
+            m_keys.at(i).button->setInstrumentation(enabled ? m_instrumentation.get() : nullptr, i);
+        }
+    }
+    if (!enabled) {
+        m_instrumentation.reset();
+    }
+}
+
+void VirtualKeyboardWidget::setInstrumentationInterval(int intervalMs) {
+    m_instrumentationTimer.setInterval(std::max(1, intervalMs));
+}
+
+InstrumentationReport VirtualKeyboardWidget::instrumentationReport() const {
+    return m_instrumentation ? m_instrumentation->report() : InstrumentationReport();
+}
+
+void VirtualKeyboardWidget::reportInstrumentation() {
+    if (m_instrumentation) {
+        // 过滤器为进程内全部键盘共用，上报的是整个进程经过它的事件数
+        if (const KeyCaptureDispatcher *dispatcher = KeyCaptureDispatcher::instance()) {
+            const quint64 filtered = dispatcher->filteredEventCount();
+            m_instrumentation->countFilteredEvents(filtered - m_filteredEventBaseline);
+            m_filteredEventBaseline = filtered;
         }
+        emit instrumentationReported(m_instrumentation->takeReport());
+    }
+}
+
+void VirtualKeyboardWidget::setTransitionOverlayCount(int count) {
+    count = std::max(0, count);
+    if (m_transitionOverlayCount == count) {
+        return;
     }
+    m_transitionOverlayCount = count;
+    scheduleTransitionOverlay();
 }
 
 void VirtualKeyboardWidget::setAutoScaleContent(bool enabled) {
@@ -181,12 +329,56 @@ void VirtualKeyboardWidget::setAutoScaleContent(bool enabled) {
     applyAutoScale();
 }
 
+void VirtualKeyboardWidget::setRenderMode(RenderMode mode) {
+    if (m_renderMode == mode) {
+        return;
+    }
+    m_renderMode = mode;
+    rebuildKeyButtons();
+    applyAutoScale();
+    refreshHeatMap();
+    update();
+}
+
+void VirtualKeyboardWidget::setGlowDuration(int durationMs) {
+    m_glowDurationMs = std::max(1, durationMs);
+}
+
+HeatMapRenderOptions VirtualKeyboardWidget::heatMapRenderOptions() const {
+    HeatMapRenderOptions options;
+    options.size = size();
+    options.devicePixelRatio = devicePixelRatioF();
+    options.gradient = m_heatGradient;
+    options.heatMapEnabled = m_heatMapEnabled;
+    // 自适应开启时按输出高度重新缩放，否则沿用控件当前实际使用的字体
+    options.font = m_autoScaleContent ? m_keyFont : m_scaledFont;
+    options.autoScaleContent = m_autoScaleContent;
+    options.highlightColor = m_highlightColor;
+    options.margins = m_layout->contentsMargins();
+    options.spacing = m_layout->spacing();
+    options.logicalDpi = logicalDpiY();
+    // 贴图转为 QImage，工作线程中不能使用 QPixmap
+    for (auto it = m_keyBackgrounds.cbegin(); it != m_keyBackgrounds.cend(); ++it) {
+        if (!it.value().isNull()) {
+            options.keyBackgrounds.insert(it.key(), it.value().toImage());
+        }
+    }
+    const auto ids = m_textureAtlas.ids();
+    for (int id : ids) {
+        options.keyBackgrounds.insert(id, m_textureAtlas.image(id));
+    }
+    return options;
+}
+
 void VirtualKeyboardWidget::setKeyFont(const QFont &font) {
     m_keyFont = font;
+    m_scaledFont = font;
+    m_scaledFonts.clear();
+    invalidateKeyCapLayers();
     // 同步字体到所有键
-    for (auto button : m_keyButtons) {
-        if (button) {
-            button->setFont(font);
+    for (const KeyCell &cell : std::as_const(m_keys)) {
+        if (cell.button) {
+            cell.button->setFont(font);
         }
     }
     applyAutoScale();
@@ -194,136 +386,931 @@ void VirtualKeyboardWidget::setKeyFont(const QFont &font) {
 
 void VirtualKeyboardWidget::setKeyBackgroundImage(int qtKey, const QString &imagePath) {
     // 载入并分发指定按键的背景图
-    QPixmap pixmap(imagePath);
-    m_keyBackgrounds.insert(qtKey, pixmap);
-    setKeyBackgroundPixmap(qtKey, pixmap);
+    setKeyBackgroundPixmap(qtKey, QPixmap(imagePath));
+}
+
+void VirtualKeyboardWidget::setKeyBackgroundImageAsync(int qtKey, const QString &imagePath) {
+    // 替换同一键上尚未完成的加载
+    cancelBackgroundLoad(qtKey);
+
+    // 已完成布局时按键帽实际设备像素尺寸解码，否则按原图解码
+    const QSize targetSize = keyDisplaySize(qtKey);
+    const quint64 requestId = BackgroundImageLoader::instance()->load(imagePath, targetSize, this,
+        [this, qtKey](const QImage &image) {
+            m_backgroundRequests.remove(qtKey);
+            if (!image.isNull()) {
+                setKeyBackgroundPixmap(qtKey, QPixmap::fromImage(image));
+            }
+            emit keyBackgroundImageLoaded(qtKey, !image.isNull());
+        });
+    m_backgroundRequests.insert(qtKey, requestId);
+}
+
+void VirtualKeyboardWidget::cancelBackgroundLoad(int qtKey) {
+    const auto it = m_backgroundRequests.constFind(qtKey);
+    if (it == m_backgroundRequests.cend()) {
+        return;
+    }
+    BackgroundImageLoader::instance()->cancel(it.value());
+    m_backgroundRequests.erase(it);
 }
 
 void VirtualKeyboardWidget::setKeyBackgroundPixmap(int qtKey, const QPixmap &pixmap) {
-    m_keyBackgrounds.insert(qtKey, pixmap);
-    const auto buttons = m_keyButtons.values(qtKey);
-    for (auto button : buttons) {
-        if (button) {
-            button->setBackgroundPixmap(pixmap);
-        }
+    cancelBackgroundLoad(qtKey);
+    if (m_textureAtlasEnabled) {
+        // 图集模式只保留缩小到显示尺寸的副本；新贴图原地写入页面，其余键的区域不变
+        m_textureAtlas.insert(qtKey, atlasImageFor(qtKey, pixmap.toImage()));
+        applyAtlasBackgrounds(qtKey);
+        return;
     }
+    m_keyBackgrounds.insert(qtKey, pixmap);
+    applyKeyBackground(qtKey);
 }
 
 void VirtualKeyboardWidget::clearKeyBackgroundImage(int qtKey) {
+    cancelBackgroundLoad(qtKey);
     m_keyBackgrounds.remove(qtKey);
-    const auto buttons = m_keyButtons.values(qtKey);
-    for (auto button : buttons) {
-        if (button) {
-            button->setBackgroundPixmap(QPixmap());
+    m_atlasUnfitted.remove(qtKey);
+    if (m_textureAtlas.contains(qtKey)) {
+        m_textureAtlas.remove(qtKey);
+        // 移除可能触发重排
+        applyAtlasBackgrounds(qtKey);
+    } else {
+        applyKeyBackground(qtKey);
+    }
+    const int keyIndex = keyIndexOf(qtKey);
+    for (int i = keyIndex >= 0 ? m_keyFirstCell.at(keyIndex) : -1; i >= 0; i = m_keys.at(i).nextSameKey) {
+        if (KeyButton *button = m_keys.at(i).button) {
             button->setBackgroundImagePath(QString());
         }
     }
 }
 
-void VirtualKeyboardWidget::recordKey(int qtKey) {
-    if (!m_keyButtons.contains(qtKey)) {
+void VirtualKeyboardWidget::setTextureAtlasEnabled(bool enabled) {
+    if (m_textureAtlasEnabled == enabled) {
         return;
     }
-    // 计数 + 高亮 + 刷新热力图
-    m_heatCounter[qtKey] += 1;
-    if (auto button = m_keyButtons.value(qtKey)) {
-        button->triggerGlow();
+    m_textureAtlasEnabled = enabled;
+    if (enabled) {
+        // 原图移入图集后释放
+        const QHash<int, QPixmap> backgrounds = std::exchange(m_keyBackgrounds, {});
+        for (auto it = backgrounds.cbegin(); it != backgrounds.cend(); ++it) {
+            if (!it.value().isNull()) {
+                m_textureAtlas.insert(it.key(), atlasImageFor(it.key(), it.value().toImage()));
+            }
+        }
+        for (auto it = backgrounds.cbegin(); it != backgrounds.cend(); ++it) {
+            applyKeyBackground(it.key());
+        }
+        m_atlasGeneration = m_textureAtlas.generation();
+    } else {
+        // 从图集取回各自独立的贴图（保持图集中的分辨率）
+        const auto ids = m_textureAtlas.ids();
+        for (int id : ids) {
+            m_keyBackgrounds.insert(id, QPixmap::fromImage(m_textureAtlas.image(id)));
+        }
+        m_textureAtlas.clear();
+        m_atlasUnfitted.clear();
+        m_atlasGeneration = m_textureAtlas.generation();
+        for (int id : ids) {
+            applyKeyBackground(id);
+        }
+    }
+}
+
+TextureMemoryUsage VirtualKeyboardWidget::textureMemoryUsage() const {
+    TextureMemoryUsage usage;
+    // 多个键引用同一张贴图时只计一次
+    QSet<qint64> counted;
+    for (const QPixmap &pixmap : m_keyBackgrounds) {
+        if (pixmap.isNull() || counted.contains(pixmap.cacheKey())) {
+            continue;
+        }
+        counted.insert(pixmap.cacheKey());
+        usage.sourceBytes += static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
     }
-    refreshHeatMap();
+    usage.atlasBytes = m_textureAtlas.memoryUsage();
+    usage.atlasPages = m_textureAtlas.pageCount();
+    usage.scaledCacheBytes = KeyPainter::scaledBackgroundCacheUsage();
+    return usage;
+}
+
+// 记录入口都转发到模型，画面只随 batchReady 送来的增量更新，共享模型的各视图因此保持一致
+void VirtualKeyboardWidget::recordKey(int qtKey) {
+    m_model->recordKey(qtKey);
+}
+
+void VirtualKeyboardWidget::recordKeys(QSpan<const int> keys) {
+    m_model->recordKeys(keys);
+}
+
+void VirtualKeyboardWidget::recordKeyCounts(const QHash<int, int> &counts) {
+    m_model->recordKeyCounts(counts);
+}
+
+bool VirtualKeyboardWidget::openStatisticsStore(const QString &directory) {
+    return m_model->openStatisticsStore(directory);
+}
+
+void VirtualKeyboardWidget::closeStatisticsStore() {
+    m_model->closeStatisticsStore();
 }
 
 void VirtualKeyboardWidget::setHeatSamples(const QHash<int, int> &samples) {
-    m_heatCounter = samples;
-    refreshHeatMap();
+    m_model->setCounts(samples);
 }
 
 void VirtualKeyboardWidget::clearStatistics() {
-    m_heatCounter.clear();
-    refreshHeatMap();
+    m_model->clear();
+}
+
+void VirtualKeyboardWidget::applyStatisticsBatch(const KeyStatisticsBatch &batch) {
+    if (batch.cleared) {
+        m_transitions.clear();
+        scheduleTransitionOverlay();
+        m_heatActivity.clear();
+        m_heatWindowTimer.stop();
+    }
+    if (batch.reset) {
+        // 计数被整体替换，按模型重读全部键
+        m_heatRescalePending = false;
+        refreshHeatMap();
+        m_statisticsChangePending = true;
+        requestVisualUpdate();
+        return;
+    }
+
+    // 转移按本批的按键顺序累计，键盘上没有的键打断序列
+    for (int qtKey : batch.sequence) {
+        const int keyIndex = keyIndexOf(qtKey);
+        if (keyIndex >= 0) {
+            m_transitions.recordIndex(keyIndex);
+        } else {
+            m_transitions.resetSequence();
+        }
+    }
+    if (!batch.sequence.isEmpty()) {
+        scheduleTransitionOverlay();
+    }
+
+    bool changed = false;
+    for (const KeyCountChange &change : batch.changes) {
+        changed = applyKeyChange(change) || changed;
+    }
+    // 按住时长中位数模式下，新样本可能改变本键颜色与归一化基准
+    if (m_heatMode == HeatMode::MedianDwell) {
+        for (int qtKey : batch.dwellChanged) {
+            const int keyIndex = keyIndexOf(qtKey);
+            if (keyIndex < 0) {
+                continue;
+            }
+            for (int i = m_keyFirstCell.at(keyIndex); i >= 0; i = m_keys.at(i).nextSameKey) {
+                markCellDirty(i).heatDirty = true;
+            }
+            m_heatRescalePending = true;
+            changed = true;
+        }
+    }
+    if (changed) {
+        requestVisualUpdate();
+    }
+}
+
+void VirtualKeyboardWidget::setFrameCoalescing(bool enabled) {
+    if (m_frameCoalescing == enabled) {
+        return;
+    }
+    m_frameCoalescing = enabled;
+    // 关闭合并时立即提交尚未刷新的状态
+    if (!enabled) {
+        flushPendingUpdates();
+    }
 }
 
-bool VirtualKeyboardWidget::eventFilter(QObject *watched, QEvent *event) {
-    Q_UNUSED(watched);
-    if (!m_trackPhysicalKeyboard) {
-        return QWidget::eventFilter(watched, event);
+void VirtualKeyboardWidget::flushPendingUpdates() {
+    m_frameTimer.stop();
+    // 模型中尚未发出的增量先送到各视图（已在发出过程中时直接返回）
+    m_model->flush();
+    const qint64 refreshStart = m_instrumentation ? m_instrumentation->now() : 0;
+
+    // 最大值变化时整盘重算一次，否则只刷新这一帧内被按过的键
+    const bool rescale = m_heatRescalePending && m_heatMapEnabled;
+    m_heatRescalePending = false;
+    if (rescale) {
+        // 累计与近期热度模式的最大值已增量维护；按住时长中位数可能下降，需重新取最大值
+        if (m_heatMode == HeatMode::MedianDwell) {
+            refreshHeatMap();
+        } else {
+            rescaleHeatMap();
+        }
+    }
+    for (int index : std::as_const(m_dirtyCells)) {
+        KeyCell &cell = m_keys[index];
+        if (cell.heatDirty && !rescale && m_heatMapEnabled) {
+            applyHeat(index);
+        }
+        if (cell.glowPending) {
+            startGlow(index, m_glowDurationMs);
+        }
+        cell.heatDirty = false;
+        cell.glowPending = false;
+    }
+    m_dirtyCells.clear();
+
+    if (m_instrumentation) {
+        m_instrumentation->recordStage(KeyboardInstrumentation::Stage::Refresh, m_instrumentation->now() - refreshStart);
     }
 
-    if (event->type() == QEvent::KeyPress) {
-        auto *keyEvent = static_cast<QKeyEvent *>(event);
-        // 捕获物理键盘按下并记录
-        recordKey(keyEvent->key());
+    if (m_statisticsChangePending) {
+        m_statisticsChangePending = false;
+        emit statisticsChanged();
     }
-    return QWidget::eventFilter(watched, event);
 }
 
 void VirtualKeyboardWidget::resizeEvent(QResizeEvent *event) {
     QWidget::resizeEvent(event);
-    // 尺寸改变时调整字体，保持缩放后视觉一致
+    // 批量模式下重新计算键位区域
+    if (m_renderMode == RenderMode::Batched) {
+        layoutKeyCells();
+    }
+    // 尺寸改变时调整字体，保持缩放后视觉一致；拖动缩放时合并到下一帧，只执行一次
+    scheduleAutoScale();
+    refitAtlasTextures();
+    if (m_transitionOverlay) {
+        m_transitionOverlay->setGeometry(rect());
+        scheduleTransitionOverlay();
+    }
+}
+
+void VirtualKeyboardWidget::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    // 显示后才有所在窗口（或已换到其它窗口），窗口级捕获据此更新
+    m_model->addCaptureWidget(this);
+    refitAtlasTextures();
+    scheduleTransitionOverlay();
+}
+
+void VirtualKeyboardWidget::paintEvent(QPaintEvent *event) {
+    if (m_renderMode != RenderMode::Batched) {
+        QWidget::paintEvent(event);
+        return;
+    }
+
+    const qint64 paintStart = m_instrumentation ? m_instrumentation->now() : 0;
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    KeyCapStyle style;
+    style.highlightColor = m_highlightColor;
+    style.textColor = Qt::white;
+
+    // 只绘制与脏区域相交的键帽
+    const QRect dirty = event->rect();
+    for (int i = 0; i < m_keys.size(); ++i) {
+        KeyCell &cell = m_keys[i];
+        if (!dirty.intersects(cell.geometry.toAlignedRect())) {
+            continue;
+        }
+        // 静态层只在尺寸、字体或贴图变化后重建，每帧只合成热力色、高亮与边框
+        if (!cell.layer.matches(cell.geometry, *this)) {
+            if (cell.atlasPage) {
+                KeyPainter::updateKeyCapLayer(cell.layer, *this, cell.geometry, cell.spec.label, m_scaledFont,
+                                              style.textColor, cell.atlasPage, cell.backgroundRect);
+            } else {
+                KeyPainter::updateKeyCapLayer(cell.layer, *this, cell.geometry, cell.spec.label, m_scaledFont,
+                                              style.textColor, cell.background);
+            }
+        }
+        KeyCapState state;
+        state.heatColor = QColor::fromRgb(m_heatGradient.colorAt(cell.heatIndex));
+        state.glowLevel = cell.glowLevel;
+        state.pressed = (i == m_pressedIndex);
+        KeyPainter::paintKey(painter, cell.layer, style, state);
+        if (m_instrumentation) {
+            m_instrumentation->keyPainted(i, m_instrumentation->now());
+        }
+    }
+    if (m_instrumentation) {
+        m_instrumentation->recordStage(KeyboardInstrumentation::Stage::Paint, m_instrumentation->now() - paintStart);
+    }
+}
+
+void VirtualKeyboardWidget::mousePressEvent(QMouseEvent *event) {
+    if (m_renderMode != RenderMode::Batched || event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    m_pressedIndex = keyCellAt(event->position().toPoint());
+    if (m_pressedIndex >= 0) {
+        update(m_keys.at(m_pressedIndex).geometry.toAlignedRect());
+    }
+    event->accept();
+}
+
+void VirtualKeyboardWidget::mouseReleaseEvent(QMouseEvent *event) {
+    if (m_renderMode != RenderMode::Batched || event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+    // 与 QPushButton::clicked 一致：按下与释放落在同一键上才算一次点击
+    const int index = keyCellAt(event->position().toPoint());
+    const int pressedIndex = m_pressedIndex;
+    m_pressedIndex = -1;
+    if (pressedIndex >= 0) {
+        update(m_keys.at(pressedIndex).geometry.toAlignedRect());
+    }
+    if (index >= 0 && index == pressedIndex) {
+        recordKey(m_keys.at(index).spec.qtKey);
+    }
+    event->accept();
+}
+
+bool VirtualKeyboardWidget::applyKeyChange(const KeyCountChange &change) {
+    // 直接寻址查表得到紧凑键下标，热路径上不经过哈希
+    const int keyIndex = keyIndexOf(change.qtKey);
+    if (keyIndex < 0) {
+        return false;
+    }
+    const int firstCell = m_keyFirstCell.at(keyIndex);
+    if (m_instrumentation && change.inputNs != 0) {
+        for (int i = firstCell; i >= 0; i = m_keys.at(i).nextSameKey) {
+            m_instrumentation->markInput(i, change.inputNs);
+        }
+    }
+    // 只标记脏键，画面刷新推迟到 flushPendingUpdates
+    if (m_heatMode == HeatMode::Cumulative) {
+        const int total = m_model->count(change.qtKey);
+        if (total > m_heatMax) {
+            // 最大值被刷新，归一化基准改变，需要整盘重算
+            m_heatMax = total;
+            m_heatRescalePending = true;
+        }
+    } else if (m_heatMode != HeatMode::MedianDwell) {
+        // 近期热度只对本键 O(1) 累加。衰减模式下全部键按同一比例缩小，其余键相对最大值的比例不变，
+        // 只需把最大值折算到此刻再与本键比较；超过时才整盘重算，否则只重绘本键。
+        // 滑动窗口的过期由 m_heatWindowTimer 按桶宽整盘刷新
+        const qint64 nowMs = m_animationClock.elapsed();
+        m_heatActivity.add(keyIndex, change.delta, nowMs);
+        m_heatMax = m_heatActivity.decayed(m_heatMax, nowMs - m_heatMaxMs);
+        m_heatMaxMs = nowMs;
+        const qreal value = m_heatActivity.value(keyIndex, nowMs);
+        if (value > m_heatMax) {
+            m_heatMax = value;
+            m_heatRescalePending = true;
+        }
+        if (m_heatMode == HeatMode::SlidingWindow && !m_heatWindowTimer.isActive()) {
+            m_heatWindowTimer.start(static_cast<int>(m_heatActivity.bucketWidth()));
+        }
+    }
+    for (int i = firstCell; i >= 0; i = m_keys.at(i).nextSameKey) {
+        markCellDirty(i).heatDirty = true;
+    }
+    // 同一键有多个键位时只高亮第一个
+    markCellDirty(firstCell).glowPending = true;
+    m_statisticsChangePending = true;
+    return true;
+}
+
+KeyCell &VirtualKeyboardWidget::markCellDirty(int index) {
+    KeyCell &cell = m_keys[index];
+    if (!cell.heatDirty && !cell.glowPending) {
+        m_dirtyCells.append(index);
+    }
+    return cell;
+}
+
+void VirtualKeyboardWidget::applyKeyBackground(int qtKey) {
+    // 图集键只引用共享页面与子区域，不复制贴图
+    const std::shared_ptr<const QPixmap> atlasPage = m_textureAtlas.page(qtKey);
+    const QRect sourceRect = m_textureAtlas.rect(qtKey);
+    const QPixmap pixmap = atlasPage ? QPixmap() : m_keyBackgrounds.value(qtKey);
+
+    const int keyIndex = keyIndexOf(qtKey);
+    for (int i = keyIndex >= 0 ? m_keyFirstCell.at(keyIndex) : -1; i >= 0; i = m_keys.at(i).nextSameKey) {
+        KeyCell &cell = m_keys[i];
+        cell.background = pixmap;
+        cell.atlasPage = atlasPage;
+        cell.backgroundRect = sourceRect;
+        cell.layer.invalidate();
+        if (cell.button) {
+            if (atlasPage) {
+                cell.button->setBackgroundRegion(atlasPage, sourceRect);
+            } else {
+                cell.button->setBackgroundPixmap(pixmap);
+            }
+        } else {
+            update(cell.geometry.toAlignedRect());
+        }
+    }
+}
+
+void VirtualKeyboardWidget::applyAtlasBackgrounds(int qtKey) {
+    if (m_textureAtlas.generation() == m_atlasGeneration) {
+        if (qtKey >= 0) {
+            applyKeyBackground(qtKey);
+        }
+        return;
+    }
+    // 重新打包后旧区域失效，逐键换用一次即可；qtKey 已从图集移除时单独清除
+    m_atlasGeneration = m_textureAtlas.generation();
+    const auto ids = m_textureAtlas.ids();
+    for (int id : ids) {
+        applyKeyBackground(id);
+    }
+    if (qtKey >= 0 && !m_textureAtlas.contains(qtKey)) {
+        applyKeyBackground(qtKey);
+    }
+}
+
+QSize VirtualKeyboardWidget::keyDisplaySize(int qtKey) const {
+    if (!isVisible()) {
+        return QSize();
+    }
+    QSize size;
+    const int keyIndex = keyIndexOf(qtKey);
+    for (int i = keyIndex >= 0 ? m_keyFirstCell.at(keyIndex) : -1; i >= 0; i = m_keys.at(i).nextSameKey) {
+        const KeyCell &cell = m_keys.at(i);
+        size = size.expandedTo(cell.button ? cell.button->size() : cell.geometry.size().toSize());
+    }
+    if (size.isEmpty()) {
+        return QSize();
+    }
+    return (QSizeF(size) * devicePixelRatio()).toSize();
+}
+
+QImage VirtualKeyboardWidget::atlasImageFor(int qtKey, const QImage &source) {
+    if (source.isNull()) {
+        return source;
+    }
+    // 尚未显示时先按上限缩小，显示后再按实际尺寸整理
+    QSize bound = keyDisplaySize(qtKey);
+    if (bound.isEmpty()) {
+        bound = QSize(512, 512);
+        m_atlasUnfitted.insert(qtKey);
+    } else {
+        m_atlasUnfitted.remove(qtKey);
+    }
+    // 只缩小不放大：保留刚好覆盖显示区域的分辨率，裁剪交给绘制阶段
+    const QSize fitted = source.size().scaled(bound, Qt::KeepAspectRatioByExpanding);
+    if (fitted.width() < source.width() && fitted.height() < source.height()) {
+        return source.scaled(fitted, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    return source;
+}
+
+void VirtualKeyboardWidget::refitAtlasTextures() {
+    if (m_atlasUnfitted.isEmpty() || !isVisible()) {
+        return;
+    }
+    const QSet<int> pending = m_atlasUnfitted;
+    for (int qtKey : pending) {
+        if (m_textureAtlas.contains(qtKey) && !keyDisplaySize(qtKey).isEmpty()) {
+            m_textureAtlas.insert(qtKey, atlasImageFor(qtKey, m_textureAtlas.image(qtKey)));
+        }
+    }
+    // 缩小后留下的空洞一次性回收，全部图集键换用新区域
+    m_textureAtlas.compact();
+    applyAtlasBackgrounds(-1);
+}
+
+void VirtualKeyboardWidget::requestVisualUpdate() {
+    if (!m_frameCoalescing) {
+        flushPendingUpdates();
+        return;
+    }
+    // 每帧最多刷新一次：首个脏标记启动单次计时器，同一帧内的后续事件只累计
+    if (!m_frameTimer.isActive()) {
+        m_frameTimer.start(frameIntervalMs());
+    }
+}
+
+int VirtualKeyboardWidget::frameIntervalMs() const {
+    const QScreen *currentScreen = screen();
+    const qreal refreshRate = currentScreen ? currentScreen->refreshRate() : 60.0;
+    return std::max(1, qRound(1000.0 / std::max<qreal>(refreshRate, 1.0)));
+}
+
+void VirtualKeyboardWidget::onGlowStep() {
+    const qint64 now = m_animationClock.elapsed();
+    // 一次推进全部活动高亮，只重绘这些键；结束的键移出活动列表
+    for (int i = m_activeGlows.size() - 1; i >= 0; --i) {
+        const int index = m_activeGlows.at(i);
+        KeyCell &cell = m_keys[index];
+        const qreal progress = static_cast<qreal>(now - cell.glowStartMs) / cell.glowDurationMs;
+        cell.glowLevel = std::max<qreal>(0.0, 1.0 - progress);
+        applyGlow(index);
+        if (cell.glowLevel <= 0.0) {
+            m_activeGlows.removeAt(i);
+        }
+    }
+    // 无活动动画时停表，空闲时不占用 CPU
+    if (m_activeGlows.isEmpty()) {
+        m_glowTimer.stop();
+    }
+}
+
+void VirtualKeyboardWidget::startGlow(int index, int durationMs) {
+    KeyCell &cell = m_keys[index];
+    cell.glowLevel = 1.0;
+    cell.glowStartMs = m_animationClock.elapsed();
+    cell.glowDurationMs = std::max(1, durationMs);
+    if (!m_activeGlows.contains(index)) {
+        m_activeGlows.append(index);
+    }
+    applyGlow(index);
+    if (!m_glowTimer.isActive()) {
+        m_glowTimer.start();
+    }
+}
+
+void VirtualKeyboardWidget::applyGlow(int index) {
+    const KeyCell &cell = m_keys.at(index);
+    if (m_renderMode == RenderMode::Batched) {
+        update(cell.geometry.toAlignedRect());
+    } else if (cell.button) {
+        cell.button->setGlowLevel(cell.glowLevel);
+    }
+}
+
+void VirtualKeyboardWidget::setKeyboardLayout(const KeyboardLayout &layout) {
+    if (layout.isEmpty()) {
+        return;
+    }
+    applyKeyboardLayout(layout);
+    m_heatRescalePending = false;
+    refreshHeatMap();
     applyAutoScale();
+    scheduleTransitionOverlay();
+    updateGeometry();
+    // 可见计数随键集合变化
+    m_statisticsChangePending = true;
+    requestVisualUpdate();
+    emit keyboardLayoutChanged();
+}
+
+void VirtualKeyboardWidget::applyKeyboardLayout(const KeyboardLayout &layout) {
+    const QVector<int> previousKeyCodes = m_keyCodes;
+    m_keyboardLayout = layout;
+
+    // 旧下标全部失效：停止渐隐、丢弃待刷新列表
+    m_glowTimer.stop();
+    m_activeGlows.clear();
+    m_dirtyCells.clear();
+    m_pressedIndex = -1;
+
+    // 键位单元原地复用，多出的子控件隐藏后收入备用池
+    const QVector<KeyboardLayout::Key> &keys = layout.keys();
+    for (int i = keys.size(); i < m_keys.size(); ++i) {
+        if (KeyButton *button = m_keys.at(i).button) {
+            button->hide();
+            m_spareButtons.append(button);
+        }
+    }
+    m_keys.resize(keys.size());
+
+    // 重建紧凑键下标：常用键直接寻址，区间外的少数键走溢出表；同一键的多个键位串成链表
+    m_keyIndexTable.fill(-1);
+    m_extraKeyIndex.clear();
+    m_keyCodes.clear();
+    m_keyFirstCell.clear();
+    QVector<int> lastCell;
+    for (int i = 0; i < keys.size(); ++i) {
+        const KeyboardLayout::Key &key = keys.at(i);
+        KeyCell &cell = m_keys[i];
+        KeyButton *button = cell.button;
+        cell = KeyCell();
+        cell.button = button;
+        cell.spec = {key.label, key.qtKey, key.columnSpan, key.rowSpan};
+        cell.row = key.row;
+        cell.column = key.column;
+        cell.keyIndex = keyIndexOf(key.qtKey);
+        if (cell.keyIndex < 0) {
+            cell.keyIndex = m_keyCodes.size();
+            const int slot = KeyLayoutTables::keySlot(key.qtKey);
+            if (slot >= 0) {
+                m_keyIndexTable[slot] = static_cast<qint16>(cell.keyIndex);
+            } else {
+                m_extraKeyIndex.insert(key.qtKey, cell.keyIndex);
+            }
+            m_keyCodes.append(key.qtKey);
+            m_keyFirstCell.append(i);
+            lastCell.append(i);
+        } else {
+            m_keys[lastCell.at(cell.keyIndex)].nextSameKey = i;
+            lastCell[cell.keyIndex] = i;
+        }
+    }
+
+    // 网格行列：旧布局多出的行列拉伸置 0
+    const int previousRows = m_rowCount;
+    const int previousColumns = m_columnCount;
+    m_rowCount = layout.rowCount();
+    m_columnCount = layout.columnCount();
+    for (int row = 0; row < std::max(previousRows, m_rowCount); ++row) {
+        m_layout->setRowStretch(row, row < m_rowCount ? 1 : 0);
+    }
+    for (int col = 0; col < std::max(previousColumns, m_columnCount); ++col) {
+        m_layout->setColumnStretch(col, col < m_columnCount ? 1 : 0);
+    }
+
+    // 近期热度与转移按 Qt::Key 迁移到新下标（计数在模型中按 Qt::Key 保存，无需迁移）
+    QVector<int> newIndex(previousKeyCodes.size());
+    for (int k = 0; k < previousKeyCodes.size(); ++k) {
+        newIndex[k] = keyIndexOf(previousKeyCodes.at(k));
+    }
+    m_heatActivity.remapKeys(newIndex, m_keyCodes.size());
+    m_transitions.remapKeys(m_keyCodes);
+    if (m_instrumentation) {
+        m_instrumentation->setSlotCount(m_keys.size());
+    }
+
+    if (m_renderMode == RenderMode::Batched) {
+        layoutKeyCells();
+        update();
+    } else {
+        placeKeyButtons();
+    }
+    // 贴图按 Qt::Key 保存，重新分发到新键位（复用的子控件同时清掉旧贴图）
+    for (int qtKey : std::as_const(m_keyCodes)) {
+        applyKeyBackground(qtKey);
+    }
 }
 
-void VirtualKeyboardWidget::addKey(int row, int column, const KeySpec &spec) {
-    auto *button = new KeyButton(spec.label, this);
-    button->setFont(m_keyFont);
-    button->setHeatColors(m_coldColor, m_hotColor);
+void VirtualKeyboardWidget::addKey(int index) {
+    KeyCell &cell = m_keys[index];
+    const KeySpec &spec = cell.spec;
+    // 优先取用布局切换时收起的子控件
+    KeyButton *button = m_spareButtons.isEmpty() ? nullptr : m_spareButtons.takeLast();
+    if (button) {
+        disconnect(button, &QPushButton::clicked, this, nullptr);
+        button->setText(spec.label);
+        button->setGlowLevel(0.0);
+        button->show();
+    } else {
+        button = new KeyButton(spec.label, this);
+    }
+    button->setFont(m_scaledFont);
+    button->setHeatGradient(m_heatGradient);
     button->setHighlightColor(m_highlightColor);
     button->setBaseTextColor(Qt::white);
+    button->setInstrumentation(m_instrumentation.get(), index);
 
-    m_layout->addWidget(button, row, column, spec.rowSpan, spec.columnSpan);
-    m_keyButtons.insertMulti(spec.qtKey, button);
+    m_layout->addWidget(button, cell.row, cell.column, spec.rowSpan, spec.columnSpan);
+    cell.button = button;
 
     // 若已有背景贴图配置则立即应用，保证设计期/运行期一致
-    if (m_keyBackgrounds.contains(spec.qtKey)) {
-        button->setBackgroundPixmap(m_keyBackgrounds.value(spec.qtKey));
+    if (cell.atlasPage) {
+        button->setBackgroundRegion(cell.atlasPage, cell.backgroundRect);
+    } else if (!cell.background.isNull()) {
+        button->setBackgroundPixmap(cell.background);
     }
 
-    // 点击虚拟键也会产生一次记录
-    connect(button, &QPushButton::clicked, this, [this, spec]() {
-        recordKey(spec.qtKey);
+    // 点击虚拟键也会产生一次记录；按下标取键码，布局切换后原地复用的子控件无需重连
+    connect(button, &QPushButton::clicked, this, [this, index]() {
+        recordKey(m_keys.at(index).spec.qtKey);
     });
 }
 
-void VirtualKeyboardWidget::refreshHeatMap() {
-    // 取出最大计数，避免除 0
-    int maxCount = 1;
-    if (!m_heatCounter.isEmpty()) {
-        maxCount = std::max(1, *std::max_element(m_heatCounter.begin(), m_heatCounter.end()));
+void VirtualKeyboardWidget::placeKeyButtons() {
+    // 整体取出网格项（只删除布局项，不删除子控件）再按新位置放回，免去逐个 removeWidget 的线性查找
+    while (QLayoutItem *item = m_layout->takeAt(m_layout->count() - 1)) {
+        delete item;
     }
-
-    for (auto it = m_keyButtons.begin(); it != m_keyButtons.end(); ++it) {
-        auto key = it.key();
-        auto button = it.value();
-        if (!button) {
+    for (int i = 0; i < m_keys.size(); ++i) {
+        KeyCell &cell = m_keys[i];
+        if (!cell.button) {
+            addKey(i);
             continue;
         }
+        cell.button->setText(cell.spec.label);
+        cell.button->setGlowLevel(0.0);
+        cell.button->setInstrumentation(m_instrumentation.get(), i);
+        m_layout->addWidget(cell.button, cell.row, cell.column, cell.spec.rowSpan, cell.spec.columnSpan);
+    }
+    // 新建的子控件叠在叠加层之上，重新置顶
+    if (m_transitionOverlay) {
+        m_transitionOverlay->raise();
+    }
+}
+
+void VirtualKeyboardWidget::rebuildKeyButtons() {
+    // 清理上一模式遗留的状态
+    m_glowTimer.stop();
+    m_activeGlows.clear();
+    m_pressedIndex = -1;
+    for (KeyCell &cell : m_keys) {
+        delete cell.button;
+        cell.glowLevel = 0.0;
+        cell.button = nullptr;
+        cell.layer.invalidate();
+    }
+    qDeleteAll(m_spareButtons);
+    m_spareButtons.clear();
+
+    if (m_renderMode == RenderMode::Batched) {
+        // 批量模式不再创建子控件，键位区域由本控件自行计算
+        layoutKeyCells();
+        scheduleTransitionOverlay();
+        return;
+    }
+
+    for (int i = 0; i < m_keys.size(); ++i) {
+        addKey(i);
+    }
+    // 新建的子控件叠在叠加层之上，重新置顶
+    if (m_transitionOverlay) {
+        m_transitionOverlay->raise();
+        scheduleTransitionOverlay();
+    }
+}
+
+void VirtualKeyboardWidget::layoutKeyCells() {
+    if (m_rowCount <= 0 || m_columnCount <= 0) {
+        return;
+    }
+    // 与 QGridLayout 等比拉伸的结果保持一致：扣除边距与间距后均分行列（与 HeatMapRenderer 共用同一计算）
+    const QRect area = rect().marginsRemoved(m_layout->contentsMargins());
+    const qreal spacing = m_layout->spacing();
+    for (KeyCell &cell : m_keys) {
+        cell.geometry = KeyPainter::gridCellRect(area, spacing, m_rowCount, m_columnCount, cell.row, cell.column,
+                                                 cell.spec.rowSpan, cell.spec.columnSpan);
+    }
+}
+
+int VirtualKeyboardWidget::keyCellAt(const QPoint &pos) const {
+    // 键位按行优先存放，单元数量固定且很少，线性扫描即可
+    for (int i = 0; i < m_keys.size(); ++i) {
+        if (m_keys.at(i).geometry.contains(pos)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+qreal VirtualKeyboardWidget::heatValue(int keyIndex) {
+    switch (m_heatMode) {
+    case HeatMode::Cumulative:
+        return m_model->count(m_keyCodes.at(keyIndex));
+    case HeatMode::MedianDwell:
+        // 毫秒，直方图相对误差不超过 1/8
+        return m_model->keyTimings().dwellPercentile(m_keyCodes.at(keyIndex), 50.0) / 1e6;
+    default:
+        return m_heatActivity.value(keyIndex, m_animationClock.elapsed());
+    }
+}
+
+void VirtualKeyboardWidget::refreshHeatMap() {
+    // 取出最大热度，避免除 0；累计模式下仅在批量注入、清空或配色变化时整表扫描
+    qreal maxHeat = 1.0;
+    if (m_heatMode == HeatMode::Decay || m_heatMode == HeatMode::SlidingWindow) {
+        // 衰减值随时间同比例缩小，以此刻最大值归一化，画面始终反映近期各键的相对活跃度
+        m_heatMaxMs = m_animationClock.elapsed();
+        const qreal activityMax = m_heatActivity.maxValue(m_heatMaxMs);
+        if (activityMax > 0.0) {
+            maxHeat = activityMax;
+        }
+    } else {
+        for (int keyIndex = 0; keyIndex < m_keyCodes.size(); ++keyIndex) {
+            maxHeat = std::max(maxHeat, heatValue(keyIndex));
+        }
+    }
+    m_heatMax = maxHeat;
+    rescaleHeatMap();
+}
+
+void VirtualKeyboardWidget::scheduleTransitionOverlay() {
+    if (m_transitionOverlayEnabled && !m_transitionOverlayTimer.isActive()) {
+        m_transitionOverlayTimer.start();
+    }
+}
+
+QPointF VirtualKeyboardWidget::keyCenter(int index) const {
+    const KeyCell &cell = m_keys.at(index);
+    if (m_renderMode == RenderMode::Batched) {
+        return cell.geometry.center();
+    }
+    return cell.button ? QRectF(cell.button->geometry()).center() : QPointF();
+}
+
+void VirtualKeyboardWidget::updateTransitionOverlay() {
+    if (!m_transitionOverlay) {
+        return;
+    }
+    // 只取最强的若干条，与累计的转移总数无关
+    const auto transitions = m_transitions.topTransitions(m_transitionOverlayCount);
+    QVector<TransitionOverlay::Arc> arcs;
+    arcs.reserve(transitions.size());
+    const qreal maxCount = transitions.isEmpty() ? 1.0 : transitions.first().count;
+    for (const auto &transition : transitions) {
+        TransitionOverlay::Arc arc;
+        arc.from = keyCenter(m_keyFirstCell.at(keyIndexOf(transition.fromKey)));
+        arc.to = keyCenter(m_keyFirstCell.at(keyIndexOf(transition.toKey)));
+        arc.weight = transition.count / maxCount;
+        arcs.append(arc);
+    }
+    m_transitionOverlay->setArcs(arcs);
+}
+
+void VirtualKeyboardWidget::onHeatWindowStep() {
+    refreshHeatMap();
+    if (!m_heatActivity.hasWindowActivity()) {
+        m_heatWindowTimer.stop();
+    }
+}
 
+void VirtualKeyboardWidget::rescaleHeatMap() {
+    // 归一化基准变化，所有键的热力强度都要重算
+    for (int i = 0; i < m_keys.size(); ++i) {
+        KeyCell &cell = m_keys[i];
         // 若关闭热力图则重置为 0，保持纯色
-        int count = m_heatMapEnabled ? m_heatCounter.value(key, 0) : 0;
-        button->setHeat(count, maxCount);
-        button->setHeatColors(m_coldColor, m_hotColor);
+        cell.heat = m_heatMapEnabled ? heatValue(cell.keyIndex) : 0.0;
+        cell.heatIndex = m_heatGradient.indexFor(cell.heat, m_heatMax);
+        if (cell.button) {
+            cell.button->setHeatGradient(m_heatGradient);
+            cell.button->setHeat(cell.heat, m_heatMax);
+        }
+    }
+    if (m_renderMode == RenderMode::Batched) {
+        update();
+    }
+}
+
+void VirtualKeyboardWidget::applyHeat(int index) {
+    KeyCell &cell = m_keys[index];
+    cell.heat = m_heatMapEnabled ? heatValue(cell.keyIndex) : 0.0;
+    cell.heatIndex = m_heatGradient.indexFor(cell.heat, m_heatMax);
+    if (m_renderMode == RenderMode::Batched) {
+        update(cell.geometry.toAlignedRect());
+    } else if (cell.button) {
+        cell.button->setHeat(cell.heat, m_heatMax);
     }
 }
 
+void VirtualKeyboardWidget::rebuildHeatGradient() {
+    // 配色变化时重建一次查找表，随后全部键共享这张表
+    switch (m_heatColorMap) {
+    case HeatColorMap::TwoColor:
+        m_heatGradient = HeatGradient(m_coldColor, m_hotColor);
+        break;
+    case HeatColorMap::Viridis:
+        m_heatGradient = HeatGradient::viridis();
+        break;
+    case HeatColorMap::Inferno:
+        m_heatGradient = HeatGradient::inferno();
+        break;
+    case HeatColorMap::Custom:
+        m_heatGradient = HeatGradient(m_heatColorStops);
+        break;
+    }
+    m_heatGradient.setScale(static_cast<HeatGradient::Scale>(m_heatScale));
+}
+
 void VirtualKeyboardWidget::applyAutoScale() {
+    // 同步执行时取消尚未到期的合并请求
+    m_autoScaleTimer.stop();
     // 若关闭自适应，则保持用户指定字体不变
     if (!m_autoScaleContent) {
         return;
     }
 
     // 基于行数估算单键高度，按比例设置像素字体大小，使缩放时文字与画面比例一致
-    const int rowCount = 6;
-    const QMargins margins = m_layout->contentsMargins();
-    const int availableH = std::max(height() - (margins.top() + margins.bottom())
-                                      - static_cast<int>(m_layout->spacing()) * (rowCount - 1),
-                                  1);
-    const int keyHeight = std::max(availableH / rowCount, 12);
-    const int pixelSize = std::clamp(static_cast<int>(keyHeight * 0.45), 9, 28);
-
-    QFont scaledFont = m_keyFont;
-    scaledFont.setPixelSize(pixelSize);
-    for (auto button : m_keyButtons) {
-        if (button) {
-            button->setFont(scaledFont);
+    const int pixelSize = KeyPainter::autoScalePixelSize(height(), m_rowCount, m_layout->contentsMargins(),
+                                                         m_layout->spacing());
+
+    auto cached = m_scaledFonts.find(pixelSize);
+    if (cached == m_scaledFonts.end()) {
+        QFont scaledFont = m_keyFont;
+        scaledFont.setPixelSize(pixelSize);
+        cached = m_scaledFonts.insert(pixelSize, scaledFont);
+    }
+    // 字号未变时不触碰子控件：setFont 会引发字体解析、尺寸提示失效与重新布局
+    const QFont &scaledFont = cached.value();
+    if (scaledFont == m_scaledFont) {
+        return;
+    }
+    m_scaledFont = scaledFont;
+    invalidateKeyCapLayers();
+    for (const KeyCell &cell : std::as_const(m_keys)) {
+        if (cell.button) {
+            cell.button->setFont(scaledFont);
         }
     }
 }
+
+void VirtualKeyboardWidget::scheduleAutoScale() {
+    if (!m_autoScaleContent) {
+        return;
+    }
+    if (!m_autoScaleTimer.isActive()) {
+        m_autoScaleTimer.start(frameIntervalMs());
+    }
+}
+
+void VirtualKeyboardWidget::invalidateKeyCapLayers() {
+    for (KeyCell &cell : m_keys) {
+        cell.layer.invalidate();
+    }
+    if (m_renderMode == RenderMode::Batched) {
+        update();
+    }
+}
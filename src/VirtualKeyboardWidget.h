@@ -1,14 +1,31 @@
 #pragma once
 
+#include "HeatAccumulator.h"
+#include "HeatGradient.h"
+#include "HeatMapRenderer.h"
 #include "KeyButton.h"
+#include "KeyLayoutTables.h"
+#include "KeyPainter.h"
+#include "KeyStatisticsModel.h"
+#include "KeyTextureAtlas.h"
+#include "KeyTransitionMatrix.h"
+#include "KeyboardLayout.h"
 
-#include <QEvent>
+#include <QElapsedTimer>
 #include <QGridLayout>
 #include <QHash>
 #include <QPointer>
 #include <QPixmap>
+#include <QSet>
+#include <QSpan>
+#include <QTimer>
+#include <QVector>
 #include <QWidget>
 
+#include <memory>
+
+class TransitionOverlay;
+
 // 键位布局描述，用于生成整排键
 struct KeySpec {
     QString label;      // 键帽显示文本
@@ -17,15 +34,94 @@ struct KeySpec {
     int rowSpan {1};    // 纵向跨行数
 };
 
+// 键帽贴图内存占用（字节）
+struct TextureMemoryUsage {
+    qint64 sourceBytes {0};      // 未进入图集的贴图（相同贴图只计一次）
+    qint64 atlasBytes {0};       // 图集页面
+    int atlasPages {0};          // 图集页数
+    qint64 scaledCacheBytes {0}; // 按显示尺寸缩放后的共享缓存
+};
+
+// 键位单元：布局位置 + 批量渲染模式下的键帽状态，连续存放便于一次遍历绘制与命中测试
+struct KeyCell {
+    KeySpec spec;          // 键位描述
+    int row {0};           // 所在网格行
+    int column {0};        // 所在网格列
+    int keyIndex {-1};     // 紧凑键下标（同一 Qt::Key 的多个键位共用），计数、热度与转移矩阵均按此寻址
+    int nextSameKey {-1};  // 同一键的下一个键位单元下标，-1 表示没有
+    QRectF geometry;       // 批量渲染模式下的绘制区域
+    qreal heat {0.0};      // 当前热度（按热度模式计算，已考虑热力图开关）
+    int heatIndex {0};     // 热力图配色查找表下标
+    qreal glowLevel {0.0}; // 当前高亮强度（0~1）
+    qint64 glowStartMs {0};   // 本次高亮开始时刻（动画时钟毫秒）
+    int glowDurationMs {0};   // 本次高亮渐隐时长
+    bool heatDirty {false};   // 计数已变化、等待下一帧刷新
+    bool glowPending {false}; // 等待下一帧开始高亮
+    QPixmap background;    // 键帽背景贴图（不使用图集时）
+    std::shared_ptr<const QPixmap> atlasPage; // 使用图集时的共享页面，绘制时直接取样
+    QRect backgroundRect;  // 背景在图集页面中的子区域
+    KeyCapLayer layer;     // 批量渲染模式下的键帽静态层（形状、贴图与文字），尺寸变化在绘制时检测
+    KeyButton *button {nullptr}; // 对应子控件（仅 Widgets 模式，由 rebuildKeyButtons 统一创建与销毁）
+};
+
 class VirtualKeyboardWidget : public QWidget {
     Q_OBJECT
     Q_PROPERTY(bool trackPhysicalKeyboard READ trackPhysicalKeyboard WRITE setTrackPhysicalKeyboard)
+    Q_PROPERTY(KeyStatisticsModel::CaptureScope captureScope READ captureScope WRITE setCaptureScope)
+    Q_PROPERTY(KeyStatisticsModel::AutoRepeatPolicy autoRepeatPolicy READ autoRepeatPolicy WRITE setAutoRepeatPolicy)
+    Q_PROPERTY(int keyRateLimit READ keyRateLimit WRITE setKeyRateLimit)
     Q_PROPERTY(bool heatMapEnabled READ heatMapEnabled WRITE setHeatMapEnabled)
     Q_PROPERTY(QColor coldColor READ coldColor WRITE setColdColor)
     Q_PROPERTY(QColor hotColor READ hotColor WRITE setHotColor)
     Q_PROPERTY(QColor highlightColor READ highlightColor WRITE setHighlightColor)
+    Q_PROPERTY(HeatColorMap heatColorMap READ heatColorMap WRITE setHeatColorMap)
+    Q_PROPERTY(HeatScale heatScale READ heatScale WRITE setHeatScale)
+    Q_PROPERTY(HeatMode heatMode READ heatMode WRITE setHeatMode)
+    Q_PROPERTY(int heatHalfLife READ heatHalfLife WRITE setHeatHalfLife)
+    Q_PROPERTY(int heatWindow READ heatWindow WRITE setHeatWindow)
     Q_PROPERTY(bool autoScaleContent READ autoScaleContent WRITE setAutoScaleContent)
+    Q_PROPERTY(RenderMode renderMode READ renderMode WRITE setRenderMode)
+    Q_PROPERTY(int glowDuration READ glowDuration WRITE setGlowDuration)
+    Q_PROPERTY(bool frameCoalescing READ frameCoalescing WRITE setFrameCoalescing)
+    Q_PROPERTY(bool textureAtlasEnabled READ textureAtlasEnabled WRITE setTextureAtlasEnabled)
+    Q_PROPERTY(bool transitionOverlay READ transitionOverlay WRITE setTransitionOverlay)
+    Q_PROPERTY(int transitionOverlayCount READ transitionOverlayCount WRITE setTransitionOverlayCount)
+    Q_PROPERTY(bool instrumentationEnabled READ instrumentationEnabled WRITE setInstrumentationEnabled)
+    Q_PROPERTY(int instrumentationInterval READ instrumentationInterval WRITE setInstrumentationInterval)
 public:
+    // 渲染模式：Widgets 为每个键一个 KeyButton 子控件；Batched 由本控件在一次 paintEvent 中绘制全部键帽
+    enum class RenderMode {
+        Widgets,
+        Batched
+    };
+    Q_ENUM(RenderMode)
+
+    // 热力图配色：冷/热两色、感知均匀的 viridis/inferno，或 setHeatColorStops 指定的多段渐变
+    enum class HeatColorMap {
+        TwoColor,
+        Viridis,
+        Inferno,
+        Custom
+    };
+    Q_ENUM(HeatColorMap)
+
+    // 计数到颜色的映射方式，与 HeatGradient::Scale 一一对应
+    enum class HeatScale {
+        Linear,
+        Sqrt,
+        Log
+    };
+    Q_ENUM(HeatScale)
+
+    // 热度来源：累计总次数、按半衰期指数衰减、最近一段时间窗口内的次数，或按住时长中位数
+    enum class HeatMode {
+        Cumulative,
+        Decay,
+        SlidingWindow,
+        MedianDwell
+    };
+    Q_ENUM(HeatMode)
+
     // 构造与析构
     explicit VirtualKeyboardWidget(QWidget *parent = nullptr);
     ~VirtualKeyboardWidget() override;
@@ -33,10 +129,28 @@ public:
     // 建议尺寸，便于在设计器中显示
     QSize sizeHint() const override;
 
-    bool trackPhysicalKeyboard() const { return m_trackPhysicalKeyboard; }
-    // 是否监听物理键盘事件
+    bool trackPhysicalKeyboard() const { return m_model->trackPhysicalKeyboard(); }
+    // 是否监听物理键盘事件（转发到当前统计模型，共享模型时对所有视图生效）
     void setTrackPhysicalKeyboard(bool enabled);
 
+    KeyStatisticsModel::CaptureScope captureScope() const { return m_model->captureScope(); }
+    // 物理按键的捕获范围（转发到当前统计模型）：Window 时只在本控件所在窗口上过滤
+    void setCaptureScope(KeyStatisticsModel::CaptureScope scope);
+
+    KeyStatisticsModel::AutoRepeatPolicy autoRepeatPolicy() const { return m_model->autoRepeatPolicy(); }
+    // 自动重复按键的处理方式（转发到当前统计模型）
+    void setAutoRepeatPolicy(KeyStatisticsModel::AutoRepeatPolicy policy);
+    int keyRateLimit() const { return m_model->keyRateLimit(); }
+    // 每个键每秒逐次处理的按键上限，0 表示不限（转发到当前统计模型）
+    void setKeyRateLimit(int eventsPerSecond);
+
+    // 当前统计模型，始终非空
+    KeyStatisticsModel *statisticsModel() const { return m_model; }
+    // 订阅一个共享统计模型，多个视图共用一份计数与一次事件捕获，各自只重绘本批变化的键。
+    // 传入 nullptr 时换回控件自带的模型（从零开始，默认监听物理键盘）；切换到外部模型时自带模型被销毁。
+    // 外部模型须与控件位于同一线程，先于控件销毁时控件自动换回自带模型
+    void setStatisticsModel(KeyStatisticsModel *model);
+
     bool heatMapEnabled() const { return m_heatMapEnabled; }
     // 是否启用热力图着色
     void setHeatMapEnabled(bool enabled);
@@ -49,6 +163,28 @@ public:
     // 设置热力图热色
     void setHotColor(const QColor &color);
 
+    HeatColorMap heatColorMap() const { return m_heatColorMap; }
+    // 选择热力图配色
+    void setHeatColorMap(HeatColorMap colorMap);
+    // 使用自定义多段渐变（位置 0~1），同时切换为 Custom 配色
+    void setHeatColorStops(const QGradientStops &stops);
+
+    HeatScale heatScale() const { return m_heatScale; }
+    // 设置计数到颜色的映射方式（线性、平方根、对数）
+    void setHeatScale(HeatScale scale);
+
+    HeatMode heatMode() const { return m_heatMode; }
+    // 切换热度来源；Decay/SlidingWindow 从切换时刻开始累计，累计计数不受影响
+    void setHeatMode(HeatMode mode);
+
+    int heatHalfLife() const { return static_cast<int>(m_heatActivity.halfLife()); }
+    // Decay 模式的半衰期（毫秒）
+    void setHeatHalfLife(int halfLifeMs);
+
+    int heatWindow() const { return static_cast<int>(m_heatActivity.window()); }
+    // SlidingWindow 模式的窗口长度（毫秒），修改后重新累计
+    void setHeatWindow(int windowMs);
+
     QColor highlightColor() const { return m_highlightColor; }
     // 设置高亮颜色
     void setHighlightColor(const QColor &color);
@@ -57,14 +193,89 @@ public:
     // 控制是否随控件尺寸自适应缩放字体与间距
     void setAutoScaleContent(bool enabled);
 
+    RenderMode renderMode() const { return m_renderMode; }
+    // 切换渲染模式，统计与贴图保持不变
+    void setRenderMode(RenderMode mode);
+
+    int glowDuration() const { return m_glowDurationMs; }
+    // 设置按键高亮渐隐时长（毫秒）
+    void setGlowDuration(int durationMs);
+
+    bool frameCoalescing() const { return m_frameCoalescing; }
+    // 开启后模型送来的增量只标记脏键，画面与 statisticsChanged 每个显示帧最多刷新一次
+    void setFrameCoalescing(bool enabled);
+
+    // 批量记录按键，全部累计后只刷新一次（转发到统计模型）
+    void recordKeys(QSpan<const int> keys);
+    // 批量累加计数（Qt::Key -> 增量），全部累计后只刷新一次
+    void recordKeyCounts(const QHash<int, int> &counts);
+
+    // 线程安全的按键入口：任意线程可向该队列 push(Qt::Key)，由 GUI 线程按批取出计数。
+    // 队列归统计模型所有，生产者须在模型析构前停止写入
+    KeyEventQueue *keyEventQueue() const { return m_model->keyEventQueue(); }
+
+    // 打开统计持久化目录：读取快照与日志作为初始计数（打开前已记录的计数并入其中），
+    // 之后的计数变化批量写入日志。失败时返回 false，原因见 statisticsStore()->errorString()
+    bool openStatisticsStore(const QString &directory);
+    // 写出未落盘的增量并关闭持久化，计数保留在内存中
+    void closeStatisticsStore();
+    // 当前持久化存储（未调用 openStatisticsStore 或已关闭时为空）
+    HeatStatisticsStore *statisticsStore() const { return m_model->statisticsStore(); }
+
+    // 键到键转移统计（recordKey/recordKeys/硬件键入等逐键入口更新，recordKeyCounts 不构成序列）
+    const KeyTransitionMatrix &transitionMatrix() const { return m_transitions; }
+    // 次数最多的 n 条转移
+    QVector<KeyTransitionMatrix::Transition> topTransitions(int n) const { return m_transitions.topTransitions(n); }
+
+    bool transitionOverlay() const { return m_transitionOverlayEnabled; }
+    // 在键盘上叠加最强转移的弧线（线宽与不透明度按次数加权）
+    void setTransitionOverlay(bool enabled);
+
+    int transitionOverlayCount() const { return m_transitionOverlayCount; }
+    // 叠加层绘制的转移条数
+    void setTransitionOverlayCount(int count);
+
+    bool instrumentationEnabled() const { return m_instrumentation != nullptr; }
+    // 开启性能埋点：KeyPress 到键帽绘制的延迟、各阶段耗时直方图与每秒计数，
+    // 并按 instrumentationInterval 周期发出 instrumentationReported；关闭时埋点只剩空指针判断
+    void setInstrumentationEnabled(bool enabled);
+
+    int instrumentationInterval() const { return m_instrumentationTimer.interval(); }
+    // 周期上报间隔（毫秒）
+    void setInstrumentationInterval(int intervalMs);
+
+    // 当前埋点数据，未开启时为空
+    KeyboardInstrumentation *instrumentation() const { return m_instrumentation.get(); }
+    // 自上次周期上报以来的报告，未开启时返回空报告
+    InstrumentationReport instrumentationReport() const;
+
+    // 当前键盘布局
+    const KeyboardLayout &keyboardLayout() const { return m_keyboardLayout; }
+    // 运行期切换布局：键位单元与子控件原地复用（多出的子控件收起备用），贴图按 Qt::Key 重新分发，
+    // 两套布局共有的键保留近期热度与转移统计；计数由统计模型按 Qt::Key 保存，不受切换影响。空布局被忽略
+    void setKeyboardLayout(const KeyboardLayout &layout);
+
+    // 与当前外观（尺寸、像素比、配色、字体、边距与贴图）一致的无界面渲染参数，
+    // 配合 HeatMapRenderer 输出与批量渲染模式逐像素相同的图像
+    HeatMapRenderOptions heatMapRenderOptions() const;
+
     // 配置键帽字体
     void setKeyFont(const QFont &font);
     // 为指定按键设置自定义背景图（可用于替换默认热图色块）
     void setKeyBackgroundImage(int qtKey, const QString &imagePath);
     void setKeyBackgroundPixmap(int qtKey, const QPixmap &pixmap);
+    // 异步加载背景图：在工作线程按键帽尺寸解码，完成后安装并发出 keyBackgroundImageLoaded；
+    // 加载完成前再次设置或清除该键贴图会取消本次加载
+    void setKeyBackgroundImageAsync(int qtKey, const QString &imagePath);
     // 清除指定按键的自定义背景图
     void clearKeyBackgroundImage(int qtKey);
 
+    bool textureAtlasEnabled() const { return m_textureAtlasEnabled; }
+    // 开启后键帽贴图缩小到实际显示尺寸并打包进共享图集，不再保留原图
+    void setTextureAtlasEnabled(bool enabled);
+    // 当前贴图内存占用
+    TextureMemoryUsage textureMemoryUsage() const;
+
 public slots:
     // 记录一次按键（外部调用或内部点击）
     void recordKey(int qtKey);
@@ -72,39 +283,203 @@ public slots:
     void setHeatSamples(const QHash<int, int> &samples);
     // 清空统计并刷新热力图
     void clearStatistics();
+    // 立即提交尚未刷新的计数、高亮与信号
+    void flushPendingUpdates();
+
+signals:
+    // 统计数据发生变化（帧合并模式下每帧最多发出一次）
+    void statisticsChanged();
+    // 异步贴图加载完成（success 为 false 表示解码失败）
+    void keyBackgroundImageLoaded(int qtKey, bool success);
+    // 跨线程队列出现丢弃，参数为累计丢弃数
+    void keyEventsDropped(quint64 totalDropped);
+    // 持久化存储写入失败（转发自统计模型）
+    void statisticsStoreFailed(const QString &errorString);
+    // Hold 策略下一次按住结束（转发自统计模型）
+    void keyHeld(int qtKey, qint64 durationNs);
+    // 性能埋点周期上报
+    void instrumentationReported(const InstrumentationReport &report);
+    // setKeyboardLayout 完成切换
+    void keyboardLayoutChanged();
 
 protected:
-    // 监听全局按键事件，响应硬件键盘
-    bool eventFilter(QObject *watched, QEvent *event) override;
     // 根据窗口大小动态调整字体大小，保证缩放时视觉一致
     void resizeEvent(QResizeEvent *event) override;
+    // 首次显示时按实际尺寸整理图集
+    void showEvent(QShowEvent *event) override;
+    // 批量渲染模式下一次绘制全部键帽
+    void paintEvent(QPaintEvent *event) override;
+    // 批量渲染模式下的点击命中测试
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private slots:
+    // 统一动画时钟：推进所有活动中的高亮渐隐
+    void onGlowStep();
+    // 应用统计模型送来的一批增量，只刷新本批变化的键
+    void applyStatisticsBatch(const KeyStatisticsBatch &batch);
+    // 滑动窗口中的桶过期，重算整盘热度
+    void onHeatWindowStep();
+    // 按当前最强转移与键位重新生成叠加层弧线
+    void updateTransitionOverlay();
+    // 发出一次周期埋点报告
+    void reportInstrumentation();
 
 private:
-    // 创建一个键并放入布局
-    void addKey(int row, int column, const KeySpec &spec);
-    // 根据计数刷新热力图与按钮状态
+    // 应用单个键的计数变化并标记脏键，不刷新画面；键不在当前布局中时返回 false
+    bool applyKeyChange(const KeyCountChange &change);
+    // 叠加层开启时安排一次弧线更新（合并到计时器，逐键路径只设标记）
+    void scheduleTransitionOverlay();
+    // 键位单元中心点（本控件坐标）
+    QPointF keyCenter(int index) const;
+    // 把键位单元加入待刷新列表
+    KeyCell &markCellDirty(int index);
+    // 立即刷新，或在帧合并模式下安排到下一帧
+    void requestVisualUpdate();
+    // 当前屏幕一帧的毫秒数
+    int frameIntervalMs() const;
+    // 取消指定键尚未完成的异步贴图加载
+    void cancelBackgroundLoad(int qtKey);
+    // 把指定键当前的贴图（图集子区域或原图）分发到其全部键位
+    void applyKeyBackground(int qtKey);
+    // 图集变动后分发贴图：图集重新打包过时全部图集键换用新区域，否则只更新 qtKey
+    void applyAtlasBackgrounds(int qtKey);
+    // 指定键当前显示的最大设备像素尺寸，尚未显示时返回空尺寸
+    QSize keyDisplaySize(int qtKey) const;
+    // 把贴图缩小到刚好覆盖显示尺寸，用于放入图集
+    QImage atlasImageFor(int qtKey, const QImage &source);
+    // 显示前放入图集的贴图按实际尺寸重新缩小
+    void refitAtlasTextures();
+    // 按布局重建键位单元与紧凑键下标，并迁移按 Qt::Key 对应的统计
+    void applyKeyboardLayout(const KeyboardLayout &layout);
+    // 为下标 index 的键位单元创建（或从备用池取出）一个 KeyButton 并放入布局
+    void addKey(int index);
+    // 布局切换后把子控件按新位置放回网格，已有子控件只更新文本
+    void placeKeyButtons();
+    // 让指定键位开始一次高亮渐隐，由统一动画时钟驱动
+    void startGlow(int index, int durationMs);
+    // 把键位单元当前的高亮强度同步到画面（子控件或批量绘制区域）
+    void applyGlow(int index);
+    // 按当前渲染模式创建或销毁子控件
+    void rebuildKeyButtons();
+    // 批量渲染模式下按网格计算每个键的绘制区域
+    void layoutKeyCells();
+    // 返回 pos 处的键位单元下标，未命中返回 -1
+    int keyCellAt(const QPoint &pos) const;
+    // Qt::Key -> 紧凑键下标，不在键盘上返回 -1
+    int keyIndexOf(int qtKey) const {
+        const int slot = KeyLayoutTables::keySlot(qtKey);
+        return slot >= 0 ? m_keyIndexTable[slot] : m_extraKeyIndex.value(qtKey, -1);
+    }
+    // 按当前热度模式取紧凑下标为 keyIndex 的键在此刻的热度
+    qreal heatValue(int keyIndex);
+    // 重新计算最大热度并刷新整盘热力图
     void refreshHeatMap();
+    // 按当前最大计数重新归一化所有键
+    void rescaleHeatMap();
+    // 仅刷新单个键位单元的热力强度
+    void applyHeat(int index);
+    // 按当前配色与映射方式重建共享查找表
+    void rebuildHeatGradient();
     // 自适应字体与间距
     void applyAutoScale();
+    // 缩放过程中合并为每帧一次 applyAutoScale
+    void scheduleAutoScale();
+    // 字体变化后丢弃批量渲染模式下全部键帽静态层
+    void invalidateKeyCapLayers();
 
     QGridLayout *m_layout {nullptr};
-    // Qt::Key -> 对应 KeyButton
-    QHash<int, QPointer<KeyButton>> m_keyButtons;
-    // 按键计数表
-    QHash<int, int> m_heatCounter;
-    // 监听物理键盘开关
-    bool m_trackPhysicalKeyboard {true};
+    // 当前键盘布局
+    KeyboardLayout m_keyboardLayout;
+    // 全部键位单元，按行优先顺序连续存放
+    QVector<KeyCell> m_keys;
+    // 槽位 -> 紧凑键下标的直接寻址表（见 KeyLayoutTables::keySlot）
+    KeyLayoutTables::KeyIndexTable m_keyIndexTable {};
+    // 直接寻址区间之外的少数键（如日文输入法键）-> 紧凑键下标
+    QHash<int, int> m_extraKeyIndex;
+    // 紧凑键下标 -> Qt::Key 与第一个键位单元下标（其余经 KeyCell::nextSameKey 串联）
+    QVector<int> m_keyCodes;
+    QVector<int> m_keyFirstCell;
+    // 网格行列数
+    int m_rowCount {0};
+    int m_columnCount {0};
+    // 布局切换时多出的子控件，隐藏后留给之后的布局复用
+    QVector<KeyButton *> m_spareButtons;
+    // 当前渲染模式
+    RenderMode m_renderMode {RenderMode::Widgets};
+    // 统一动画时钟：单个计时器推进所有键的渐隐，无活动高亮时停止
+    QTimer m_glowTimer;
+    // 动画时间基准
+    QElapsedTimer m_animationClock;
+    // 正在渐隐的键位单元下标
+    QVector<int> m_activeGlows;
+    // 高亮渐隐时长
+    int m_glowDurationMs {900};
+    // 帧合并开关与计时器
+    bool m_frameCoalescing {false};
+    QTimer m_frameTimer;
+    // 等待刷新的键位单元下标
+    QVector<int> m_dirtyCells;
+    // 最大计数已变化，等待整盘重算
+    bool m_heatRescalePending {false};
+    // 统计已变化，等待发出 statisticsChanged
+    bool m_statisticsChangePending {false};
+    // 批量渲染模式下当前按下的键位单元下标
+    int m_pressedIndex {-1};
+    // 当前热力图最大热度；累计模式下 recordKey 时增量维护，避免每次按键整表扫描
+    qreal m_heatMax {1.0};
+    // 近期热度模式下 m_heatMax 对应的动画时钟时刻，衰减模式按此折算到当前
+    qint64 m_heatMaxMs {0};
+    // 统计模型（计数、事件捕获与持久化）及其是否为控件自带
+    QPointer<KeyStatisticsModel> m_model;
+    bool m_ownsModel {false};
+    // 键到键转移矩阵
+    KeyTransitionMatrix m_transitions;
+    // 转移叠加层、开关、绘制条数与更新节流计时器
+    QPointer<TransitionOverlay> m_transitionOverlay;
+    bool m_transitionOverlayEnabled {false};
+    int m_transitionOverlayCount {12};
+    QTimer m_transitionOverlayTimer;
+    // 性能埋点（未开启时为空）与上报计时器
+    std::unique_ptr<KeyboardInstrumentation> m_instrumentation;
+    QTimer m_instrumentationTimer;
+    // 上次上报时按键捕获过滤器处理过的事件总数
+    quint64 m_filteredEventBaseline {0};
     // 热力图开关
     bool m_heatMapEnabled {true};
     // 热力图冷/热色
     QColor m_coldColor {QColor(18, 26, 38)};
     QColor m_hotColor {QColor(126, 192, 255)};
+    // 热力图配色方案、自定义色标、映射方式与共享查找表
+    HeatColorMap m_heatColorMap {HeatColorMap::TwoColor};
+    QGradientStops m_heatColorStops;
+    HeatScale m_heatScale {HeatScale::Linear};
+    HeatGradient m_heatGradient;
+    // 热度来源、近期热度与滑动窗口过期计时器
+    HeatMode m_heatMode {HeatMode::Cumulative};
+    HeatAccumulator m_heatActivity;
+    QTimer m_heatWindowTimer;
     // 高亮颜色
     QColor m_highlightColor {QColor(255, 65, 130)};
     // 键帽字体
     QFont m_keyFont;
+    // 自适应缩放后实际使用的字体
+    QFont m_scaledFont;
+    // 按像素大小缓存的缩放字体，拖动缩放时在几种字号间往返不再重新构造字体；m_keyFont 变化时清空
+    QHash<int, QFont> m_scaledFonts;
     // 是否启用自适应缩放
     bool m_autoScaleContent {true};
+    // 缩放时的自适应计时器，一帧内的多次 resizeEvent 只执行一次
+    QTimer m_autoScaleTimer;
     // 每个按键可选的背景贴图
     QHash<int, QPixmap> m_keyBackgrounds;
+    // Qt::Key -> 未完成的异步加载请求编号
+    QHash<int, quint64> m_backgroundRequests;
+    // 键帽贴图图集及开关
+    KeyTextureAtlas m_textureAtlas;
+    bool m_textureAtlasEnabled {false};
+    // 各键位当前引用的图集区域对应的图集代号
+    quint64 m_atlasGeneration {0};
+    // 显示前放入图集、尚未按实际尺寸缩小的键
+    QSet<int> m_atlasUnfitted;
 };